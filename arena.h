@@ -0,0 +1,318 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Allocators for node-based containers such as std_::unordered_set, which
+// otherwise make one call to operator new per element. arena_allocator
+// never frees individual elements, and releases them all at once when its
+// arena is reset; it suits tables that are built and then discarded, such
+// as per-request temporaries. pool_allocator recycles freed nodes, for
+// long-lived tables with a lot of churn. For example:
+//
+//   hashing::arena arena;
+//   std_::unordered_set<int, Hash, std::equal_to<int>,
+//                       hashing::arena_allocator<int>>
+//       set(hashing::arena_allocator<int>(arena));
+//
+// Neither is thread-safe: an arena or pool must only be used by one
+// thread at a time.
+
+#ifndef HASHING_DEMO_ARENA_H
+#define HASHING_DEMO_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+namespace hashing {
+
+// Allocates memory by advancing a pointer through large blocks, which are
+// obtained from operator new with geometrically increasing sizes.
+// Deallocation is a no-op; memory is only released by reset() or by the
+// destructor.
+class arena {
+  // Header at the start of each block.
+  struct block {
+    block* prev;
+    size_t size;
+  };
+
+  block* blocks_ = nullptr;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t next_block_size_;
+
+ public:
+  explicit arena(size_t initial_block_size = 4096)
+      : next_block_size_(initial_block_size) {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() { release_blocks(); }
+
+  // Returns 'size' bytes aligned to 'alignment', which must be a power of
+  // two.
+  void* allocate(size_t size, size_t alignment) {
+    char* const p = next_ + (-reinterpret_cast<uintptr_t>(next_) &
+                             (alignment - 1));
+    if (p > end_ || static_cast<size_t>(end_ - p) < size) {
+      return allocate_from_new_block(size, alignment);
+    }
+    next_ = p + size;
+    return p;
+  }
+
+  // Frees everything allocated from the arena, which invalidates all
+  // containers that are still using it. The memory is kept for reuse, in a
+  // single block as large as all the blocks so far, so an arena that is
+  // reset after each request soon stops calling operator new at all.
+  void reset() {
+    if (blocks_ == nullptr) return;
+    if (blocks_->prev != nullptr) {
+      size_t total_size = 0;
+      for (block* b = blocks_; b != nullptr; b = b->prev) {
+        total_size += b->size;
+      }
+      release_blocks();
+      add_block(total_size);
+    }
+    next_ = reinterpret_cast<char*>(blocks_ + 1);
+  }
+
+ private:
+  void* allocate_from_new_block(size_t size, size_t alignment) {
+    const size_t overhead = sizeof(block) + alignment;
+    if (size > std::numeric_limits<size_t>::max() - overhead) {
+      throw std::bad_alloc();
+    }
+    size_t block_size = next_block_size_;
+    while (block_size < size + overhead) {
+      block_size *= 2;
+    }
+    next_block_size_ = block_size * 2;
+    add_block(block_size);
+    return allocate(size, alignment);
+  }
+
+  void add_block(size_t size) {
+    block* b = static_cast<block*>(::operator new(size));
+    b->prev = blocks_;
+    b->size = size;
+    blocks_ = b;
+    next_ = reinterpret_cast<char*>(b + 1);
+    end_ = reinterpret_cast<char*>(b) + size;
+  }
+
+  void release_blocks() {
+    while (blocks_ != nullptr) {
+      block* prev = blocks_->prev;
+      ::operator delete(blocks_);
+      blocks_ = prev;
+    }
+    next_ = end_ = nullptr;
+  }
+};
+
+// Allocates nodes from per-size free lists, which are refilled from an
+// arena. Nodes are returned to their free list when deallocated, and their
+// memory is only released when the pool is destroyed. Allocations larger
+// than kMaxNodeSize, such as a hash table's bucket array, and over-aligned
+// allocations go directly to operator new.
+class node_pool {
+ public:
+  static constexpr size_t kMaxNodeSize = 256;
+
+ private:
+  static constexpr size_t kGranularity = alignof(std::max_align_t);
+  static constexpr size_t kSizeClasses = kMaxNodeSize / kGranularity;
+
+  // The alignment that plain operator new guarantees.
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+  static constexpr size_t kNewAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+  static constexpr size_t kNewAlignment = alignof(std::max_align_t);
+#endif
+
+  struct free_node {
+    free_node* next;
+  };
+
+  free_node* free_lists_[kSizeClasses] = {};
+  arena arena_;
+
+  static size_t size_class(size_t size) {
+    return (size + kGranularity - 1) / kGranularity - 1;
+  }
+
+  static bool is_pooled(size_t size, size_t alignment) {
+    return size > 0 && size <= kMaxNodeSize && alignment <= kGranularity;
+  }
+
+  static void* allocate_unpooled(size_t size, size_t alignment) {
+    if (alignment <= kNewAlignment) {
+      return ::operator new(size);
+    }
+#ifdef __cpp_aligned_new
+    return ::operator new(size, std::align_val_t(alignment));
+#else
+    // Without C++17's aligned operator new, over-allocate, and store the
+    // pointer that operator new returned just before the aligned block.
+    if (size > std::numeric_limits<size_t>::max() - alignment -
+                   sizeof(void*)) {
+      throw std::bad_alloc();
+    }
+    void* raw = ::operator new(size + alignment - 1 + sizeof(void*));
+    const uintptr_t first = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    void** p = reinterpret_cast<void**>((first + alignment - 1) &
+                                        ~uintptr_t{alignment - 1});
+    p[-1] = raw;
+    return p;
+#endif
+  }
+
+  static void deallocate_unpooled(void* p, size_t alignment) noexcept {
+    if (alignment <= kNewAlignment) {
+      ::operator delete(p);
+      return;
+    }
+#ifdef __cpp_aligned_new
+    ::operator delete(p, std::align_val_t(alignment));
+#else
+    ::operator delete(static_cast<void**>(p)[-1]);
+#endif
+  }
+
+ public:
+  explicit node_pool(size_t initial_block_size = 4096)
+      : arena_(initial_block_size) {}
+
+  node_pool(const node_pool&) = delete;
+  node_pool& operator=(const node_pool&) = delete;
+
+  void* allocate(size_t size, size_t alignment) {
+    if (!is_pooled(size, alignment)) {
+      return allocate_unpooled(size, alignment);
+    }
+    free_node*& free_list = free_lists_[size_class(size)];
+    if (free_list == nullptr) {
+      return arena_.allocate((size_class(size) + 1) * kGranularity,
+                             kGranularity);
+    }
+    free_node* node = free_list;
+    free_list = node->next;
+    return node;
+  }
+
+  // 'size' and 'alignment' must be the values that 'p' was allocated with.
+  void deallocate(void* p, size_t size, size_t alignment) noexcept {
+    if (!is_pooled(size, alignment)) {
+      deallocate_unpooled(p, alignment);
+      return;
+    }
+    free_node*& free_list = free_lists_[size_class(size)];
+    free_list = ::new (p) free_node{free_list};
+  }
+};
+
+namespace detail {
+
+// Returns n * sizeof(T), or throws std::bad_alloc on overflow.
+template <typename T>
+size_t allocation_size(size_t n) {
+  if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+    throw std::bad_alloc();
+  }
+  return n * sizeof(T);
+}
+
+}  // namespace detail
+
+// Standard allocator that allocates from an arena, which it refers to but
+// does not own. The arena must outlive every container using it.
+template <typename T>
+class arena_allocator {
+  template <typename U>
+  friend class arena_allocator;
+
+  arena* arena_;
+
+ public:
+  using value_type = T;
+
+  explicit arena_allocator(arena& a) noexcept : arena_(&a) {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        arena_->allocate(detail::allocation_size<T>(n), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) noexcept {}
+
+  friend bool operator==(const arena_allocator& lhs,
+                         const arena_allocator& rhs) {
+    return lhs.arena_ == rhs.arena_;
+  }
+
+  friend bool operator!=(const arena_allocator& lhs,
+                         const arena_allocator& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+// Standard allocator that allocates from a node_pool, which it refers to
+// but does not own. The pool must outlive every container using it.
+template <typename T>
+class pool_allocator {
+  template <typename U>
+  friend class pool_allocator;
+
+  node_pool* pool_;
+
+ public:
+  using value_type = T;
+
+  explicit pool_allocator(node_pool& pool) noexcept : pool_(&pool) {}
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U>& other) noexcept
+      : pool_(other.pool_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        pool_->allocate(detail::allocation_size<T>(n), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    pool_->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  friend bool operator==(const pool_allocator& lhs,
+                         const pool_allocator& rhs) {
+    return lhs.pool_ == rhs.pool_;
+  }
+
+  friend bool operator!=(const pool_allocator& lhs,
+                         const pool_allocator& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_ARENA_H
@@ -0,0 +1,180 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "arena.h"
+#include "std.h"
+
+namespace {
+
+template <typename T, typename Allocator>
+using Set = std_::unordered_set<T, std_::hash<T>, std::equal_to<T>, Allocator>;
+
+bool IsAligned(const void* p, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+TEST(ArenaTest, AllocationsAreAlignedAndDisjoint) {
+  hashing::arena arena(64);
+  std::vector<std::pair<char*, size_t>> allocations;
+  for (size_t alignment : {1, 2, 8, 16, 64, 4, 32}) {
+    for (size_t size : {1, 7, 24, 100}) {
+      char* p = static_cast<char*>(arena.allocate(size, alignment));
+      EXPECT_TRUE(IsAligned(p, alignment)) << size << " " << alignment;
+      allocations.emplace_back(p, size);
+    }
+  }
+  std::sort(allocations.begin(), allocations.end());
+  for (size_t i = 1; i < allocations.size(); ++i) {
+    EXPECT_LE(allocations[i - 1].first + allocations[i - 1].second,
+              allocations[i].first);
+  }
+}
+
+TEST(ArenaTest, LargeAllocation) {
+  hashing::arena arena(64);
+  char* p = static_cast<char*>(arena.allocate(1 << 20, 16));
+  memset(p, 0, 1 << 20);
+  EXPECT_TRUE(IsAligned(p, 16));
+}
+
+TEST(ArenaTest, ResetMergesBlocks) {
+  hashing::arena arena(256);
+  for (int i = 0; i < 100; ++i) {
+    arena.allocate(64, 8);
+  }
+  arena.reset();
+  // The 100 allocations took several blocks, which were merged into one,
+  // so they are now carved from it contiguously.
+  char* first = static_cast<char*>(arena.allocate(64, 8));
+  for (int i = 1; i < 100; ++i) {
+    EXPECT_EQ(first + 64 * i, arena.allocate(64, 8));
+  }
+  arena.reset();
+  EXPECT_EQ(first, arena.allocate(64, 8));
+}
+
+TEST(ArenaTest, SetWithArenaAllocator) {
+  hashing::arena arena;
+  for (int round = 0; round < 3; ++round) {
+    {
+      using Allocator = hashing::arena_allocator<std::string>;
+      Set<std::string, Allocator> set{Allocator(arena)};
+      for (int i = 0; i < 1000; ++i) {
+        set.insert(std::to_string(i));
+      }
+      EXPECT_EQ(1000, set.size());
+      EXPECT_EQ(1, set.count("123"));
+      EXPECT_EQ(0, set.count("1000"));
+      set.erase("123");
+      EXPECT_EQ(0, set.count("123"));
+    }
+    arena.reset();
+  }
+}
+
+TEST(NodePoolTest, RecyclesNodesBySize) {
+  hashing::node_pool pool;
+  void* a = pool.allocate(24, 8);
+  void* b = pool.allocate(40, 8);
+  EXPECT_TRUE(IsAligned(a, alignof(std::max_align_t)));
+  EXPECT_TRUE(IsAligned(b, alignof(std::max_align_t)));
+  pool.deallocate(a, 24, 8);
+  pool.deallocate(b, 40, 8);
+  // Sizes in the same size class share a free list.
+  EXPECT_EQ(a, pool.allocate(20, 4));
+  EXPECT_EQ(b, pool.allocate(40, 8));
+  EXPECT_NE(a, pool.allocate(24, 8));
+}
+
+TEST(NodePoolTest, LargeAllocationsBypassThePool) {
+  hashing::node_pool pool;
+  const size_t size = hashing::node_pool::kMaxNodeSize + 1;
+  char* p = static_cast<char*>(pool.allocate(size, 8));
+  memset(p, 0, size);
+  pool.deallocate(p, size, 8);
+}
+
+struct alignas(64) CacheLine {
+  int i;
+
+  friend bool operator==(const CacheLine& lhs, const CacheLine& rhs) {
+    return lhs.i == rhs.i;
+  }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const CacheLine& c) {
+    return hash_combine(std::move(h), c.i);
+  }
+};
+
+TEST(NodePoolTest, OverAlignedAllocations) {
+  hashing::node_pool pool;
+  std::vector<std::pair<void*, size_t>> allocations;
+  for (size_t size : {size_t{64}, size_t{192},
+                      hashing::node_pool::kMaxNodeSize + 64}) {
+    for (int i = 0; i < 8; ++i) {
+      void* p = pool.allocate(size, 64);
+      EXPECT_TRUE(IsAligned(p, 64)) << size;
+      memset(p, 0, size);
+      allocations.emplace_back(p, size);
+    }
+  }
+  for (const auto& allocation : allocations) {
+    pool.deallocate(allocation.first, allocation.second, 64);
+  }
+
+  using Allocator = hashing::pool_allocator<CacheLine>;
+  Set<CacheLine, Allocator> set{Allocator(pool)};
+  for (int i = 0; i < 100; ++i) {
+    set.insert(CacheLine{i});
+  }
+  for (const CacheLine& c : set) {
+    EXPECT_TRUE(IsAligned(&c, 64)) << c.i;
+  }
+  EXPECT_EQ(1, set.count(CacheLine{42}));
+}
+
+TEST(NodePoolTest, SetWithPoolAllocator) {
+  hashing::node_pool pool;
+  using Allocator = hashing::pool_allocator<int>;
+  Set<int, Allocator> set{Allocator(pool)};
+  for (int round = 0; round < 3; ++round) {
+    set.clear();
+    for (int i = 0; i < 1000; ++i) {
+      set.insert(i);
+    }
+    EXPECT_EQ(1000, set.size());
+    for (int i = 0; i < 1000; i += 2) {
+      set.erase(i);
+    }
+    EXPECT_EQ(500, set.size());
+    EXPECT_EQ(0, set.count(2));
+    EXPECT_EQ(1, set.count(3));
+  }
+  Set<int, Allocator> copy(set, Allocator(pool));
+  EXPECT_EQ(set, copy);
+}
+
+}  // namespace
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+# Copyright 2015 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Benchmark regression gate.
+
+Runs the benchmarks binary with repetitions and JSON output, and compares
+the throughput of each configuration against a baseline recorded earlier
+on the same machine. A configuration counts as a regression only if its median throughput is
+more than --threshold below the baseline median AND a one-sided
+Mann-Whitney U test over the repetitions rejects "no slowdown" at level
+--alpha, so ordinary run-to-run noise does not fail the gate.
+
+Baselines are only meaningful on the machine and build configuration that
+recorded them, so none is checked in. To record one, from a Release build
+on the gating machine, run with --update:
+
+  $ ./benchmark_gate.py --benchmarks=./benchmarks --build_type=Release \
+        --baseline=benchmark_baseline.json --update
+
+The gate refuses to compare against a baseline whose build type or host
+(name, CPUs, benchmark library build type) differs from this run's, since
+the comparison would say nothing about the code. A different reported
+clock only draws a warning, as it varies between runs on hosts with
+frequency scaling or turbo.
+
+Exits with status 1 if any configuration regressed, 2 on usage errors and
+context mismatches.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+DEFAULT_FILTER = r'^BM_Hash(Strings|X)<'
+AGGREGATE_SUFFIXES = ('_mean', '_median', '_stddev', '_cv')
+CONTEXT_KEYS = ('host_name', 'num_cpus', 'library_build_type', 'build_type')
+# Recorded and compared, but a mismatch is not fatal.
+WARNING_CONTEXT_KEYS = ('mhz_per_cpu',)
+
+
+def run_benchmarks(binary, benchmark_filter, repetitions, min_time):
+  """Returns the parsed JSON output of one run of the benchmarks binary."""
+  fd, out_path = tempfile.mkstemp(suffix='.json')
+  os.close(fd)
+  try:
+    subprocess.check_call([
+        binary,
+        '--benchmark_filter=' + benchmark_filter,
+        '--benchmark_repetitions=%d' % repetitions,
+        '--benchmark_min_time=%g' % min_time,
+        '--benchmark_out=' + out_path,
+        '--benchmark_out_format=json',
+    ], stdout=subprocess.DEVNULL)
+    with open(out_path) as f:
+      return json.load(f)
+  finally:
+    os.remove(out_path)
+
+
+def throughput(run):
+  """Returns the throughput of a single run, higher being better."""
+  for counter in ('bytes_per_second', 'items_per_second'):
+    if counter in run:
+      return counter, float(run[counter])
+  return 'iterations_per_cpu_second', 1.0 / float(run['cpu_time'])
+
+
+def collect_samples(output):
+  """Groups the per-repetition runs in 'output' by configuration name."""
+  results = {}
+  for run in output['benchmarks']:
+    if run.get('run_type') == 'aggregate' or 'aggregate_name' in run:
+      continue
+    name = run.get('run_name', run['name'])
+    if name.endswith(AGGREGATE_SUFFIXES):
+      continue
+    metric, value = throughput(run)
+    entry = results.setdefault(name, {'metric': metric, 'samples': []})
+    entry['samples'].append(value)
+  return results
+
+
+def median(values):
+  values = sorted(values)
+  n = len(values)
+  return (values[(n - 1) // 2] + values[n // 2]) / 2.0
+
+
+def mann_whitney_less(xs, ys):
+  """One-sided p-value for the hypothesis that xs tends to be less than ys.
+
+  Uses the normal approximation to the distribution of U, with tie and
+  continuity corrections, which is adequate for the repetition counts used
+  here (the gate refuses fewer than 5 per side).
+  """
+  n1, n2 = len(xs), len(ys)
+  ranked = sorted([(x, 0) for x in xs] + [(y, 1) for y in ys])
+  ranks = [0.0] * len(ranked)
+  tie_term = 0.0
+  i = 0
+  while i < len(ranked):
+    j = i
+    while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+      j += 1
+    for k in range(i, j + 1):
+      ranks[k] = (i + j) / 2.0 + 1
+    t = j - i + 1
+    tie_term += t ** 3 - t
+    i = j + 1
+  r1 = sum(r for r, (_, group) in zip(ranks, ranked) if group == 0)
+  u1 = r1 - n1 * (n1 + 1) / 2.0
+  n = n1 + n2
+  mean = n1 * n2 / 2.0
+  variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+  if variance <= 0:
+    return 1.0
+  z = (u1 - mean + 0.5) / math.sqrt(variance)
+  return 0.5 * math.erfc(-z / math.sqrt(2))
+
+
+def compare(baseline, current, threshold, alpha):
+  """Prints a comparison table and returns the names that regressed."""
+  regressions = []
+  width = max(len(name) for name in list(baseline) + list(current))
+  print('%-*s %9s %9s' % (width, 'Benchmark', 'Change', 'p-value'))
+  for name in sorted(set(baseline) | set(current)):
+    if name not in current:
+      print('%-*s   missing from this run' % (width, name))
+      continue
+    if name not in baseline:
+      print('%-*s   new (no baseline)' % (width, name))
+      continue
+    old, new = baseline[name], current[name]
+    if old['metric'] != new['metric']:
+      print('%-*s   metric changed from %s to %s' %
+            (width, name, old['metric'], new['metric']))
+      continue
+    change = median(new['samples']) / median(old['samples']) - 1
+    p = mann_whitney_less(new['samples'], old['samples'])
+    verdict = ''
+    if change < -threshold and p < alpha:
+      verdict = '  REGRESSION'
+      regressions.append(name)
+    print('%-*s %+8.1f%% %9.4f%s' % (width, name, 100 * change, p, verdict))
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument('--benchmarks', required=True,
+                      help='path to the benchmarks binary')
+  parser.add_argument('--baseline', required=True, help='baseline file')
+  parser.add_argument('--build_type', default='',
+                      help='CMake build type of the benchmarks binary')
+  parser.add_argument('--filter', default=DEFAULT_FILTER,
+                      help='benchmarks to gate on (default: %(default)s)')
+  parser.add_argument('--repetitions', type=int, default=10,
+                      help='runs of each configuration (default: %(default)s)')
+  parser.add_argument('--min_time', type=float, default=0.2,
+                      help='seconds per repetition (default: %(default)s)')
+  parser.add_argument('--threshold', type=float, default=0.05,
+                      help='tolerated fractional slowdown of the median '
+                      '(default: %(default)s)')
+  parser.add_argument('--alpha', type=float, default=0.01,
+                      help='significance level (default: %(default)s)')
+  parser.add_argument('--update', action='store_true',
+                      help='record a new baseline instead of comparing')
+  args = parser.parse_args()
+  if args.repetitions < 5:
+    parser.error('--repetitions must be at least 5')
+  if args.update and args.build_type.lower() != 'release':
+    parser.error('baselines must be recorded from a Release build '
+                 '(--build_type=Release)')
+  if not args.update and not os.path.exists(args.baseline):
+    parser.error('no baseline at %s; record one on this machine with '
+                 '--update' % args.baseline)
+
+  output = run_benchmarks(args.benchmarks, args.filter, args.repetitions,
+                          args.min_time)
+  current = collect_samples(output)
+  if not current:
+    parser.error('no benchmarks matched %r' % args.filter)
+  context = {k: output['context'].get(k)
+             for k in CONTEXT_KEYS + WARNING_CONTEXT_KEYS}
+  context['build_type'] = args.build_type
+
+  if args.update:
+    with open(args.baseline, 'w') as f:
+      json.dump({'context': context, 'filter': args.filter,
+                 'benchmarks': current}, f, indent=2, sort_keys=True)
+      f.write('\n')
+    print('Wrote %d configurations to %s' % (len(current), args.baseline))
+    return 0
+
+  with open(args.baseline) as f:
+    baseline = json.load(f)
+  for key in WARNING_CONTEXT_KEYS:
+    if baseline['context'].get(key) != context[key]:
+      print('warning: baseline %s is %r, but this run has %r' %
+            (key, baseline['context'].get(key), context[key]), file=sys.stderr)
+  mismatches = [key for key in CONTEXT_KEYS
+                if baseline['context'].get(key) != context[key]]
+  for key in mismatches:
+    print('error: baseline %s is %r, but this run has %r' %
+          (key, baseline['context'].get(key), context[key]), file=sys.stderr)
+  if mismatches:
+    print('The baseline was recorded in a different context; record a new '
+          'one with --update.', file=sys.stderr)
+    return 2
+  # Only gate on the configurations this run was asked for.
+  pattern = re.compile(args.filter)
+  reference = {name: entry for name, entry in baseline['benchmarks'].items()
+               if pattern.search(name)}
+
+  regressions = compare(reference, current, args.threshold, args.alpha)
+  if regressions:
+    print('\n%d configuration(s) regressed by more than %g%%:' %
+          (len(regressions), 100 * args.threshold))
+    for name in regressions:
+      print('  ' + name)
+    return 1
+  print('\nNo regressions.')
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -14,17 +14,40 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstring>
+#include <forward_list>
 #include <functional>
+#include <memory>
+#include <numeric>
 #include <random>
+#include <set>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "benchmark/benchmark.h"
 
+#include "arena.h"
 #include "farmhash.h"
 #include "farmhash-direct.h"
+#include "fnv1a.h"
+#include "intern_pool.h"
+#include "multi_hash.h"
 #include "n3980.h"
+#include "n3980-adapters.h"
 #include "n3980-farmhash.h"
+#include "pimpl.h"
+#include "similarity.h"
 #include "std.h"
 
 static const int kNumBytes = 10'000'000;
@@ -39,6 +62,115 @@ static const std::array<unsigned char, kNumBytes>& Bytes() {
   return kBytes;
 }
 
+// Hardware performance counters, reported as per-iteration user counters
+// (cycles, instructions, IPC, branch misses, L1 data cache and last-level
+// cache misses). Construct a PerfCounters just before a benchmark's
+// KeepRunning() loop: it counts user-space events in the calling thread
+// until it is destroyed, so setup code before the loop is excluded.
+// Counters that cannot be opened (e.g. on systems other than Linux, on
+// machines without an accessible PMU, or when perf_event_paranoid forbids
+// it) are silently omitted.
+class PerfCounters {
+ public:
+  explicit PerfCounters(benchmark::State& state) : state_(state) {
+    for (Event& event : events_) {
+      event.fd = Open(event.type, event.config);
+    }
+    for (const Event& event : events_) {
+      Control(event.fd, /*enable=*/true);
+    }
+  }
+
+  ~PerfCounters() {
+    for (const Event& event : events_) {
+      Control(event.fd, /*enable=*/false);
+    }
+    double values[kNumEvents];
+    for (int i = 0; i < kNumEvents; ++i) {
+      values[i] = Read(events_[i].fd);
+      if (values[i] >= 0 && state_.iterations() > 0) {
+        state_.counters[events_[i].name] = benchmark::Counter(
+            values[i], benchmark::Counter::kAvgIterations);
+      }
+    }
+    if (values[kCycles] > 0 && values[kInstructions] >= 0) {
+      state_.counters["IPC"] = values[kInstructions] / values[kCycles];
+    }
+  }
+
+ private:
+  enum { kCycles, kInstructions, kNumEvents = 5 };
+
+  struct Event {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+    int fd;
+  };
+
+  benchmark::State& state_;
+
+#ifdef __linux__
+  static int Open(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // The events are opened separately rather than as a group, so that
+    // the ones that are available still work if others are not. The
+    // kernel may then multiplex them, which Read() corrects for.
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  static void Control(int fd, bool enable) {
+    if (fd >= 0) {
+      ioctl(fd, enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  // Returns the event count, scaled for multiplexing, or -1 if the event
+  // is unavailable. Closes fd.
+  static double Read(int fd) {
+    if (fd < 0) return -1;
+    uint64_t data[3];  // value, time enabled, time running
+    const bool ok = read(fd, data, sizeof(data)) == sizeof(data);
+    close(fd);
+    if (!ok || data[2] == 0) return -1;
+    return static_cast<double>(data[0]) * data[1] / data[2];
+  }
+
+  static constexpr uint64_t kL1dReadMiss =
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+  std::array<Event, kNumEvents> events_ = {{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1},
+    {"L1d-misses", PERF_TYPE_HW_CACHE, kL1dReadMiss, -1},
+    {"LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1},
+  }};
+#else
+  static int Open(uint32_t, uint64_t) { return -1; }
+  static void Control(int, bool) {}
+  static double Read(int) { return -1; }
+
+  std::array<Event, kNumEvents> events_ = {{
+    {"cycles", 0, 0, -1},
+    {"instructions", 0, 0, -1},
+    {"branch-misses", 0, 0, -1},
+    {"L1d-misses", 0, 0, -1},
+    {"LLC-misses", 0, 0, -1},
+  }};
+#endif
+};
+
 struct string_piece {
   string_piece(const unsigned char* begin, const unsigned char* end)
       : begin(reinterpret_cast<const char*>(begin)),
@@ -87,6 +219,7 @@ static void BM_HashStrings(benchmark::State& state) {
 
   int i = 0;
   H h;
+  PerfCounters perf_counters(state);
   while (state.KeepRunning()) {
     benchmark::DoNotOptimize(h(string_piece{&bytes[i], &bytes[i+string_size]}));
     i = (i + 1) % (kNumBytes - string_size);
@@ -104,6 +237,261 @@ BENCHMARK_TEMPLATE(BM_HashStrings, farmhash_hasher<string_piece>)
 BENCHMARK_TEMPLATE(BM_HashStrings, std_::uhash<hashing::n3980::farmhash>)
     ->Range(1, 1000 * 1000);
 
+// Cold-cache variant of BM_HashStrings: each input starts at a
+// pseudo-random offset in a buffer much larger than the last-level cache,
+// so it is usually read from memory rather than from cache.
+static const size_t kNumColdBytes = size_t{256} << 20;
+static const std::vector<unsigned char>& ColdBytes() {
+  static const std::vector<unsigned char> kColdBytes = [](){
+    std::vector<unsigned char> bytes(kNumColdBytes);
+    std::mt19937_64 engine;
+    for (size_t i = 0; i < bytes.size(); i += sizeof(uint64_t)) {
+      const uint64_t word = engine();
+      memcpy(&bytes[i], &word, sizeof(word));
+    }
+    return bytes;
+  }();
+  return kColdBytes;
+}
+
+template <class H>
+static void BM_HashStringsColdCache(benchmark::State& state) {
+  const unsigned char* bytes = ColdBytes().data();
+
+  const int string_size = state.range_x();
+
+  // Generate offsets with a 64-bit LCG rather than reading them from a
+  // table, which would add memory traffic of its own.
+  uint64_t lcg = 0;
+  H h;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL;
+    const size_t i = (lcg >> 24) % (kNumColdBytes - string_size);
+    benchmark::DoNotOptimize(
+        h(string_piece{bytes + i, bytes + i + string_size}));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          string_size);
+}
+
+BENCHMARK_TEMPLATE(BM_HashStringsColdCache, farmhash_string_direct)
+    ->Range(1, 64 * 1024);
+
+BENCHMARK_TEMPLATE(BM_HashStringsColdCache, farmhash_hasher<string_piece>)
+    ->Range(1, 64 * 1024);
+
+BENCHMARK_TEMPLATE(BM_HashStringsColdCache,
+                   std_::uhash<hashing::n3980::farmhash>)
+    ->Range(1, 64 * 1024);
+
+// Variant of BM_HashStrings with explicit control of input alignment:
+// every input of kStringSize bytes starts at the given offset (0-63) from
+// a 64-byte boundary. BM_HashStrings instead steps through all alignments
+// in a fixed pattern. The inputs stay hot in cache.
+struct alignas(64) AlignedBytes {
+  static const int kNumSlots = 64;
+  static const int kSlotSize = 64 + 1024;
+  unsigned char bytes[kNumSlots * kSlotSize];
+};
+
+static const AlignedBytes& GetAlignedBytes() {
+  static const AlignedBytes kAlignedBytes = [](){
+    AlignedBytes aligned;
+    std::copy(Bytes().begin(), Bytes().begin() + sizeof(aligned.bytes),
+              aligned.bytes);
+    return aligned;
+  }();
+  return kAlignedBytes;
+}
+
+template <class H, int kStringSize>
+static void BM_HashStringsAligned(benchmark::State& state) {
+  static_assert(kStringSize + 64 <= AlignedBytes::kSlotSize,
+                "kStringSize is too large");
+  const unsigned char* bytes = GetAlignedBytes().bytes;
+
+  const int alignment = state.range_x();
+
+  int slot = 0;
+  H h;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    const unsigned char* begin =
+        bytes + slot * AlignedBytes::kSlotSize + alignment;
+    benchmark::DoNotOptimize(h(string_piece{begin, begin + kStringSize}));
+    slot = (slot + 1) % AlignedBytes::kNumSlots;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kStringSize);
+}
+
+#define BENCHMARK_HASH_STRINGS_ALIGNED(hasher)                        \
+  BENCHMARK_TEMPLATE2(BM_HashStringsAligned, hasher, 8)->DenseRange(0, 63);   \
+  BENCHMARK_TEMPLATE2(BM_HashStringsAligned, hasher, 64)->DenseRange(0, 63);  \
+  BENCHMARK_TEMPLATE2(BM_HashStringsAligned, hasher, 1024)->DenseRange(0, 63)
+
+BENCHMARK_HASH_STRINGS_ALIGNED(farmhash_string_direct);
+BENCHMARK_HASH_STRINGS_ALIGNED(farmhash_hasher<string_piece>);
+BENCHMARK_HASH_STRINGS_ALIGNED(std_::uhash<hashing::n3980::farmhash>);
+
+// Multi-threaded variants of BM_HashStrings, which report the aggregate
+// throughput of all threads. Each thread walks a slice of Bytes() of the
+// same size under every policy, so that the policies differ only in which
+// slice that is, not in how well it fits in cache:
+//
+// SharedData: every thread walks the first slice, so they all read the
+// same (read-only) cache lines.
+struct SharedData {
+  static bool Disjoint() { return false; }
+  static bool FetchPerIteration() { return false; }
+};
+
+// DisjointData: each thread walks its own slice.
+struct DisjointData {
+  static bool Disjoint() { return true; }
+  static bool FetchPerIteration() { return false; }
+};
+
+// SharedDataViaStatic: like SharedData, but calls Bytes() on every
+// iteration, as code that keeps tables in function-local statics does.
+// This exposes the cost of the static's initialization guard.
+struct SharedDataViaStatic {
+  static bool Disjoint() { return false; }
+  static bool FetchPerIteration() { return true; }
+};
+
+// Maximum number of threads that get disjoint slices of Bytes().
+static const int kMaxThreadSlices = 64;
+static const int kThreadSliceSize = kNumBytes / kMaxThreadSlices;
+
+template <class H, class Data>
+static void BM_HashStringsThreaded(benchmark::State& state) {
+  // Assign slices in order of arrival, rather than using the thread
+  // index, so that slices stay disjoint however threads are numbered.
+  static std::atomic<int> next_slice(0);
+  const int slice = next_slice++ % kMaxThreadSlices;
+
+  const int string_size = state.range_x();
+  const int begin = Data::Disjoint() ? slice * kThreadSliceSize : 0;
+  const int end = begin + kThreadSliceSize - string_size;
+  assert(begin < end);
+
+  const unsigned char* const data = Bytes().data();
+  int i = begin;
+  H h;
+  while (state.KeepRunning()) {
+    const unsigned char* bytes =
+        Data::FetchPerIteration() ? Bytes().data() : data;
+    benchmark::DoNotOptimize(
+        h(string_piece{bytes + i, bytes + i + string_size}));
+    if (++i == end) i = begin;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          string_size);
+}
+
+#define BENCHMARK_HASH_STRINGS_THREADED(hasher, data)        \
+  BENCHMARK_TEMPLATE2(BM_HashStringsThreaded, hasher, data)  \
+      ->Arg(64)->Arg(4096)->Arg(64 * 1024)                   \
+      ->ThreadRange(1, 32)->UseRealTime()
+
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_string_direct, SharedData);
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_string_direct, DisjointData);
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_string_direct, SharedDataViaStatic);
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_hasher<string_piece>, SharedData);
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_hasher<string_piece>, DisjointData);
+BENCHMARK_HASH_STRINGS_THREADED(farmhash_hasher<string_piece>,
+                                SharedDataViaStatic);
+BENCHMARK_HASH_STRINGS_THREADED(std_::uhash<hashing::n3980::farmhash>,
+                                SharedData);
+BENCHMARK_HASH_STRINGS_THREADED(std_::uhash<hashing::n3980::farmhash>,
+                                DisjointData);
+BENCHMARK_HASH_STRINGS_THREADED(std_::uhash<hashing::n3980::farmhash>,
+                                SharedDataViaStatic);
+
+// Hashers for BM_HashBytesByLength, which hash exactly the given bytes
+// (unlike the hashers above, which also hash the string length), so that
+// all three implementations hit FarmHash's length-class boundaries at the
+// same input lengths.
+struct farmhash_bytes_direct {
+  size_t operator()(const unsigned char* begin, const unsigned char* end) {
+    return hashing::direct::farmhash::Hash64(
+        reinterpret_cast<const char*>(begin), end - begin);
+  }
+};
+
+struct farmhash_bytes {
+  size_t operator()(const unsigned char* begin, const unsigned char* end) {
+    hashing::farmhash::state_type state;
+    return hashing::farmhash::result_type(
+        hash_combine_range(hashing::farmhash{&state}, begin, end));
+  }
+};
+
+struct farmhash_bytes_n3980 {
+  size_t operator()(const unsigned char* begin, const unsigned char* end) {
+    hashing::n3980::farmhash h;
+    h(begin, end - begin);
+    return static_cast<size_t>(h);
+  }
+};
+
+// Per-length latency sweep over short inputs. Unlike the Range() used by
+// BM_HashStrings, this covers every length, including the branch
+// boundaries at 4, 8, 16, 32, 64 and 65 bytes. Run with
+// --benchmark_filter=BM_HashBytesByLength --benchmark_format=csv to get
+// ns/hash for each implementation and length in a plottable form.
+template <class H>
+static void BM_HashBytesByLength(benchmark::State& state) {
+  const std::array<unsigned char, kNumBytes>& bytes = Bytes();
+
+  const int length = state.range_x();
+
+  int i = 0;
+  H h;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(&bytes[i], &bytes[i + length]));
+    i = (i + 1) % (kNumBytes - length);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * length);
+}
+
+BENCHMARK_TEMPLATE(BM_HashBytesByLength, farmhash_bytes_direct)
+    ->DenseRange(0, 256);
+
+BENCHMARK_TEMPLATE(BM_HashBytesByLength, farmhash_bytes)
+    ->DenseRange(0, 256);
+
+BENCHMARK_TEMPLATE(BM_HashBytesByLength, farmhash_bytes_n3980)
+    ->DenseRange(0, 256);
+
+// Throughput for large inputs, hashed in a single call, as when hashing a
+// whole file. The largest sizes are bound by memory bandwidth.
+template <class H>
+static void BM_HashLargeInput(benchmark::State& state) {
+  const std::vector<unsigned char>& bytes = ColdBytes();
+  const size_t length = state.range_x();
+  assert(length <= bytes.size());
+
+  H h;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(bytes.data(), bytes.data() + length));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * length);
+}
+
+BENCHMARK_TEMPLATE(BM_HashLargeInput, farmhash_bytes_direct)
+    ->RangeMultiplier(4)->Range(1 << 20, 256 << 20);
+
+BENCHMARK_TEMPLATE(BM_HashLargeInput, farmhash_bytes)
+    ->RangeMultiplier(4)->Range(1 << 20, 256 << 20);
+
+BENCHMARK_TEMPLATE(BM_HashLargeInput, farmhash_bytes_n3980)
+    ->RangeMultiplier(4)->Range(1 << 20, 256 << 20);
+
 // Based on N3980's "X", but data_ is non-contiguous, in order to exercise
 // a different part of the performance space.
 struct X {
@@ -111,6 +499,10 @@ struct X {
   std::vector<std::pair<char, int>>                data_;
 };
 
+bool operator==(const X& lhs, const X& rhs) {
+  return lhs.date_ == rhs.date_ && lhs.data_ == rhs.data_;
+}
+
 template <typename HashCode>
 HashCode hash_value(HashCode code, const X& x) {
   return hash_combine(std::move(code), x.date_, x.data_);
@@ -149,6 +541,7 @@ static void BM_HashX(benchmark::State& state) {
   int i = 0;
   int64_t cumulative_vector_size = 0;
   H h;
+  PerfCounters perf_counters(state);
   while (state.KeepRunning()) {
     benchmark::DoNotOptimize(h(xs[i]));
     i = (i + 1) % xs.size();
@@ -165,4 +558,786 @@ BENCHMARK_TEMPLATE(BM_HashX, farmhash_hasher<X>)
 BENCHMARK_TEMPLATE(BM_HashX, std_::uhash<hashing::n3980::farmhash>)
     ->Range(1, 1000 * 1000);
 
+// Hashes X with hashing::farmhash, but through X's hash_append() overload
+// and an algorithm_adapter, as for a type that only supports N3980.
+struct farmhash_via_hash_append {
+  size_t operator()(const X& x) const {
+    hashing::farmhash::state_type state;
+    return hashing::farmhash::result_type(
+        hashing::n3980::hash_value_via_hash_append(
+            hashing::farmhash{&state}, x));
+  }
+};
+
+// Hashes X with n3980::farmhash, but through X's hash_value() overload and
+// a hash_code_adapter, as for a type that only supports this proposal.
+struct n3980_farmhash_via_hash_value {
+  size_t operator()(const X& x) const {
+    hashing::n3980::farmhash h;
+    hashing::n3980::hash_append_via_hash_value(h, x);
+    return static_cast<size_t>(h);
+  }
+};
+
+BENCHMARK_TEMPLATE(BM_HashX, farmhash_via_hash_append)
+    ->Range(1, 1000 * 1000);
+
+BENCHMARK_TEMPLATE(BM_HashX, n3980_farmhash_via_hash_value)
+    ->Range(1, 1000 * 1000);
+
+// End-to-end std_::unordered_set benchmarks
+// ==========================================================================
+//
+// These measure hash table operations rather than raw hashing, for a
+// variety of key types and hashers. Table sizes range from a few elements,
+// which fit in L1, to far more than fits in the last-level cache.
+
+// Const-callable hashers for use in unordered containers. std_::hash is
+// measured directly: it takes fixed-size and short-string shortcuts that
+// farmhash_hasher (above) does not, so their digests and costs differ.
+template <typename T>
+struct fnv1a_hasher {
+  size_t operator()(const T& t) const {
+    using std_::hash_value;
+    return size_t(hash_value(hashing::fnv1a{}, t));
+  }
+};
+
+template <typename T>
+struct n3980_hasher {
+  size_t operator()(const T& t) const {
+    return std_::uhash<hashing::n3980::farmhash>{}(t);
+  }
+};
+
+// Key generators: Keys::Make(i) returns the i'th distinct key.
+struct IntKeys {
+  using type = int;
+  static int Make(int i) { return static_cast<int>(i * 2654435761u); }
+};
+
+struct ShortStringKeys {
+  using type = std::string;
+  static std::string Make(int i) { return "key:" + std::to_string(i); }
+};
+
+struct LongStringKeys {
+  using type = std::string;
+  static std::string Make(int i) {
+    const char* prefix = reinterpret_cast<const char*>(&Bytes()[i % 4096]);
+    return std::string(prefix, 96) + std::to_string(i);
+  }
+};
+
+struct XKeys {
+  using type = X;
+  static X Make(int i) {
+    X x;
+    x.date_ = std::make_tuple(static_cast<short>(1915 + i % 100),
+                              static_cast<unsigned char>(1 + i % 12),
+                              static_cast<unsigned char>(1 + i % 28));
+    for (int j = 0; j < i % 8; ++j) {
+      x.data_.emplace_back(static_cast<char>(j), i);
+    }
+    x.data_.emplace_back(static_cast<char>(i % 8), i);
+    return x;
+  }
+};
+
+struct PimplKeys {
+  using type = Pimpl;
+  static Pimpl Make(int i) { return Pimpl({i, i >> 8, i >> 16}, "abc"); }
+};
+
+template <class Keys>
+static std::vector<typename Keys::type> MakeKeys(int begin, int end) {
+  std::vector<typename Keys::type> keys;
+  keys.reserve(end - begin);
+  for (int i = begin; i < end; ++i) {
+    keys.push_back(Keys::Make(i));
+  }
+  return keys;
+}
+
+// Returns [0, n) in random order, for probing the table in an order
+// unrelated to insertion order.
+static std::vector<int> ShuffledIndices(int n) {
+  std::vector<int> indices(n);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::shuffle(indices.begin(), indices.end(), std::default_random_engine());
+  return indices;
+}
+
+template <class Keys, class Hasher>
+using KeySet = std_::unordered_set<typename Keys::type, Hasher>;
+
+// Creating the keys and destroying the table are excluded from the
+// timings of BM_SetInsert and BM_SetErase, which makes them noisy for the
+// smallest tables.
+template <class Keys, class Hasher>
+static void BM_SetInsert(benchmark::State& state) {
+  const int size = state.range_x();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    auto keys = MakeKeys<Keys>(0, size);
+    {
+      KeySet<Keys, Hasher> set;
+      state.ResumeTiming();
+      for (auto& key : keys) {
+        set.insert(std::move(key));
+      }
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+template <class Keys, class Hasher>
+static void BM_SetFindHit(benchmark::State& state) {
+  const int size = state.range_x();
+  auto keys = MakeKeys<Keys>(0, size);
+  const std::vector<int> order = ShuffledIndices(size);
+  KeySet<Keys, Hasher> set;
+  for (auto& key : keys) {
+    set.insert(std::move(key));
+  }
+  const auto probes = MakeKeys<Keys>(0, size);
+
+  int i = 0;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(set.find(probes[order[i]]));
+    i = (i + 1) % size;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Keys, class Hasher>
+static void BM_SetFindMiss(benchmark::State& state) {
+  const int size = state.range_x();
+  KeySet<Keys, Hasher> set;
+  for (auto& key : MakeKeys<Keys>(0, size)) {
+    set.insert(std::move(key));
+  }
+  const auto probes = MakeKeys<Keys>(size, 2 * size);
+
+  int i = 0;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(set.find(probes[i]));
+    i = (i + 1) % size;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Keys, class Hasher>
+static void BM_SetErase(benchmark::State& state) {
+  const int size = state.range_x();
+  const std::vector<int> order = ShuffledIndices(size);
+  const auto probes = MakeKeys<Keys>(0, size);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    {
+      KeySet<Keys, Hasher> set;
+      for (auto& key : MakeKeys<Keys>(0, size)) {
+        set.insert(std::move(key));
+      }
+      state.ResumeTiming();
+      for (int i : order) {
+        set.erase(probes[i]);
+      }
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+// Registers all four operations for the given key set and hasher, for
+// tables of up to max_size elements.
+#define BENCHMARK_UNORDERED_SET(keys, hasher, max_size)                 \
+  BENCHMARK_TEMPLATE2(BM_SetInsert, keys, hasher)->Range(8, max_size);  \
+  BENCHMARK_TEMPLATE2(BM_SetFindHit, keys, hasher)->Range(8, max_size); \
+  BENCHMARK_TEMPLATE2(BM_SetFindMiss, keys, hasher)->Range(8, max_size);\
+  BENCHMARK_TEMPLATE2(BM_SetErase, keys, hasher)->Range(8, max_size)
+
+BENCHMARK_UNORDERED_SET(IntKeys, std::hash<int>, 1 << 22);
+BENCHMARK_UNORDERED_SET(IntKeys, std_::hash<int>, 1 << 22);
+BENCHMARK_UNORDERED_SET(IntKeys, farmhash_hasher<int>, 1 << 22);
+BENCHMARK_UNORDERED_SET(IntKeys, fnv1a_hasher<int>, 1 << 22);
+BENCHMARK_UNORDERED_SET(IntKeys, n3980_hasher<int>, 1 << 22);
+
+BENCHMARK_UNORDERED_SET(ShortStringKeys, std::hash<std::string>, 1 << 20);
+BENCHMARK_UNORDERED_SET(ShortStringKeys, std_::hash<std::string>, 1 << 20);
+BENCHMARK_UNORDERED_SET(ShortStringKeys, farmhash_hasher<std::string>, 1 << 20);
+BENCHMARK_UNORDERED_SET(ShortStringKeys, fnv1a_hasher<std::string>, 1 << 20);
+BENCHMARK_UNORDERED_SET(ShortStringKeys, n3980_hasher<std::string>, 1 << 20);
+
+BENCHMARK_UNORDERED_SET(LongStringKeys, std::hash<std::string>, 1 << 18);
+BENCHMARK_UNORDERED_SET(LongStringKeys, std_::hash<std::string>, 1 << 18);
+BENCHMARK_UNORDERED_SET(LongStringKeys, farmhash_hasher<std::string>, 1 << 18);
+BENCHMARK_UNORDERED_SET(LongStringKeys, fnv1a_hasher<std::string>, 1 << 18);
+BENCHMARK_UNORDERED_SET(LongStringKeys, n3980_hasher<std::string>, 1 << 18);
+
+// X and Pimpl have no std::hash specialization, and Pimpl's type-erased
+// contents are not visible to N3980's hash_append.
+BENCHMARK_UNORDERED_SET(XKeys, std_::hash<X>, 1 << 20);
+BENCHMARK_UNORDERED_SET(XKeys, farmhash_hasher<X>, 1 << 20);
+BENCHMARK_UNORDERED_SET(XKeys, fnv1a_hasher<X>, 1 << 20);
+BENCHMARK_UNORDERED_SET(XKeys, n3980_hasher<X>, 1 << 20);
+
+BENCHMARK_UNORDERED_SET(PimplKeys, std_::hash<Pimpl>, 1 << 20);
+BENCHMARK_UNORDERED_SET(PimplKeys, farmhash_hasher<Pimpl>, 1 << 20);
+BENCHMARK_UNORDERED_SET(PimplKeys, fnv1a_hasher<Pimpl>, 1 << 20);
+
+// Repeated lookups of large immutable keys, as in a long-lived map. The
+// probes are distinct objects equal to the stored keys, so each lookup
+// hashes one; CachedPimpl hashed its contents once, at construction, and
+// only mixes in the digest.
+template <typename Key>
+struct LargePimplKeys {
+  using type = Key;
+  static Key Make(int i) { return Key(std::vector<int>(256, i), "abc"); }
+};
+
+BENCHMARK_TEMPLATE2(BM_SetFindHit, LargePimplKeys<Pimpl>,
+                    farmhash_hasher<Pimpl>)->Range(8, 1 << 14);
+BENCHMARK_TEMPLATE2(BM_SetFindHit, LargePimplKeys<CachedPimpl>,
+                    farmhash_hasher<CachedPimpl>)->Range(8, 1 << 14);
+
+// Hash code caching
+// ==========================================================================
+//
+// Compares std_::unordered_set with and without hash codes cached in its
+// nodes (see std_::cache_hash_code), for short and long strings. Strings
+// cache their hash codes by default, so the uncached variants use the same
+// keys with UncachedHash, which hashes them exactly as std_::hash does.
+// (Using a different key type that opts out of caching would also change
+// how the keys are hashed.)
+
+template <typename T>
+struct UncachedHash : std_::hash<T> {};
+
+#ifdef __GLIBCXX__
+namespace std {
+
+// As std_::hash does for types that opt out of caching, this relies on
+// libstdc++'s internal __is_fast_hash trait; other standard libraries
+// decide for themselves, and there the variants are the same.
+template <typename T>
+struct __is_fast_hash<UncachedHash<T>> : public true_type {};
+
+}  // namespace std
+#endif
+
+// The cached std_::hash<std::string> variants are registered with the other
+// hashers above.
+BENCHMARK_UNORDERED_SET(ShortStringKeys, UncachedHash<std::string>, 1 << 20);
+BENCHMARK_UNORDERED_SET(LongStringKeys, UncachedHash<std::string>, 1 << 18);
+
+// Allocator that keeps a running total of the bytes allocated through it.
+template <typename T>
+class CountingAllocator {
+  template <typename U>
+  friend class CountingAllocator;
+
+  size_t* bytes_;
+
+ public:
+  using value_type = T;
+
+  explicit CountingAllocator(size_t* bytes) : bytes_(bytes) {}
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other)
+      : bytes_(other.bytes_) {}
+
+  T* allocate(size_t n) {
+    *bytes_ += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    *bytes_ -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(const CountingAllocator& lhs,
+                         const CountingAllocator& rhs) {
+    return lhs.bytes_ == rhs.bytes_;
+  }
+
+  friend bool operator!=(const CountingAllocator& lhs,
+                         const CountingAllocator& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+// Builds a table, and reports the memory it allocates per element for its
+// nodes and buckets, excluding memory owned by the elements themselves.
+template <class Keys, class Hasher>
+static void BM_SetMemory(benchmark::State& state) {
+  using Key = typename Keys::type;
+  using Allocator = CountingAllocator<Key>;
+  const int size = state.range_x();
+  const auto keys = MakeKeys<Keys>(0, size);
+  size_t bytes = 0;
+  size_t table_bytes = 0;
+  while (state.KeepRunning()) {
+    std_::unordered_set<Key, Hasher, std::equal_to<Key>, Allocator> set{
+        Allocator(&bytes)};
+    for (const auto& key : keys) {
+      set.insert(key);
+    }
+    table_bytes = bytes;
+  }
+  state.counters["bytes_per_element"] =
+      static_cast<double>(table_bytes) / size;
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+BENCHMARK_TEMPLATE2(BM_SetMemory, ShortStringKeys, std_::hash<std::string>)
+    ->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE2(BM_SetMemory, ShortStringKeys, UncachedHash<std::string>)
+    ->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE2(BM_SetMemory, LongStringKeys, std_::hash<std::string>)
+    ->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE2(BM_SetMemory, LongStringKeys, UncachedHash<std::string>)
+    ->Range(8, 1 << 16);
+
+// Allocators for temporary tables
+// ==========================================================================
+//
+// Builds a table, probes it once per key, and discards it, as a request
+// handler would with a temporary set. This compares the default allocator
+// with hashing::arena_allocator and hashing::pool_allocator (see arena.h);
+// the table's memory is reused across iterations by resetting the arena,
+// or by returning nodes to the pool.
+
+struct DefaultAllocation {
+  template <typename T>
+  using allocator = std::allocator<T>;
+
+  template <typename T>
+  allocator<T> MakeAllocator() { return allocator<T>(); }
+
+  void Reset() {}
+};
+
+struct ArenaAllocation {
+  template <typename T>
+  using allocator = hashing::arena_allocator<T>;
+
+  hashing::arena arena;
+
+  template <typename T>
+  allocator<T> MakeAllocator() { return allocator<T>(arena); }
+
+  void Reset() { arena.reset(); }
+};
+
+struct PoolAllocation {
+  template <typename T>
+  using allocator = hashing::pool_allocator<T>;
+
+  hashing::node_pool pool;
+
+  template <typename T>
+  allocator<T> MakeAllocator() { return allocator<T>(pool); }
+
+  void Reset() {}
+};
+
+template <class Keys, class Allocation>
+static void BM_SetBuildAndDiscard(benchmark::State& state) {
+  using Key = typename Keys::type;
+  using Allocator = typename Allocation::template allocator<Key>;
+  using Set = std_::unordered_set<Key, farmhash_hasher<Key>,
+                                  std::equal_to<Key>, Allocator>;
+  const int size = state.range_x();
+  const auto keys = MakeKeys<Keys>(0, size);
+  Allocation allocation;
+
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    {
+      Set set(allocation.template MakeAllocator<Key>());
+      for (const auto& key : keys) {
+        set.insert(key);
+      }
+      for (const auto& key : keys) {
+        benchmark::DoNotOptimize(set.count(key));
+      }
+    }
+    allocation.Reset();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+#define BENCHMARK_BUILD_AND_DISCARD(keys, allocation)                    \
+  BENCHMARK_TEMPLATE2(BM_SetBuildAndDiscard, keys, allocation)          \
+      ->Range(8, 64 << 10)
+
+BENCHMARK_BUILD_AND_DISCARD(IntKeys, DefaultAllocation);
+BENCHMARK_BUILD_AND_DISCARD(IntKeys, ArenaAllocation);
+BENCHMARK_BUILD_AND_DISCARD(IntKeys, PoolAllocation);
+
+BENCHMARK_BUILD_AND_DISCARD(ShortStringKeys, DefaultAllocation);
+BENCHMARK_BUILD_AND_DISCARD(ShortStringKeys, ArenaAllocation);
+BENCHMARK_BUILD_AND_DISCARD(ShortStringKeys, PoolAllocation);
+
+// String interning
+// ==========================================================================
+//
+// Interns strings that are already interned, which is the common case,
+// with hashing::intern_pool and with a std::set of strings, which is how
+// type-invariant_test.cc's InternedString used to work.
+
+struct SetInternPool {
+  std::set<std::string> strings;
+
+  const std::string* intern(const std::string& s) {
+    return &*strings.insert(s).first;
+  }
+};
+
+template <class Pool>
+static void BM_InternHit(benchmark::State& state) {
+  const int size = state.range_x();
+  const auto keys = MakeKeys<ShortStringKeys>(0, size);
+  const std::vector<int> order = ShuffledIndices(size);
+  Pool pool;
+  for (const auto& key : keys) {
+    pool.intern(key);
+  }
+
+  int i = 0;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(pool.intern(keys[order[i]]));
+    i = (i + 1) % size;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_InternHit, SetInternPool)->Range(8, 1 << 20);
+BENCHMARK_TEMPLATE(BM_InternHit, hashing::intern_pool)->Range(8, 1 << 20);
+
+// Per-type comparison of the two proposals
+// ==========================================================================
+//
+// Hashes values of each standard type that both proposals support, with
+// hashing::farmhash via hash_value() and with n3980::farmhash via
+// hash_append(). Both feed FarmHash the same bytes (see n3980_test.cc), so
+// any difference is the cost of the API itself.
+
+static const int kNumValues = 1024;
+
+struct BoolValues {
+  using type = bool;
+  static bool Make(int i) { return i % 3 == 0; }
+};
+
+struct DoubleValues {
+  using type = double;
+  static double Make(int i) { return i * 0.5; }
+};
+
+struct PointerValues {
+  using type = const unsigned char*;
+  static const unsigned char* Make(int i) { return &Bytes()[i]; }
+};
+
+struct PairValues {
+  using type = std::pair<int, int>;
+  static std::pair<int, int> Make(int i) { return {i, -i}; }
+};
+
+struct TupleValues {
+  using type = std::tuple<int, double, std::string>;
+  static type Make(int i) {
+    return std::make_tuple(i, i * 0.5, std::to_string(i));
+  }
+};
+
+struct ArrayValues {
+  using type = std::array<int, 16>;
+  static type Make(int i) {
+    type a;
+    std::iota(a.begin(), a.end(), i);
+    return a;
+  }
+};
+
+struct DoubleVectorValues {
+  using type = std::vector<double>;
+  static type Make(int i) { return type(i % 32, i * 0.5); }
+};
+
+struct ForwardListValues {
+  using type = std::forward_list<int>;
+  static type Make(int i) { return type(i % 32, i); }
+};
+
+struct UniquePtrValues {
+  using type = std::unique_ptr<int>;
+  static type Make(int i) { return type(new int(i)); }
+};
+
+template <class Values, class Hasher>
+static void BM_HashValues(benchmark::State& state) {
+  const auto values = MakeKeys<Values>(0, kNumValues);
+
+  int i = 0;
+  Hasher h;
+  PerfCounters perf_counters(state);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(values[i]));
+    i = (i + 1) % kNumValues;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+#define BENCHMARK_HASH_VALUES(values)                                        \
+  BENCHMARK_TEMPLATE2(BM_HashValues, values, farmhash_hasher<values::type>); \
+  BENCHMARK_TEMPLATE2(BM_HashValues, values, n3980_hasher<values::type>)
+
+BENCHMARK_HASH_VALUES(BoolValues);
+BENCHMARK_HASH_VALUES(DoubleValues);
+BENCHMARK_HASH_VALUES(PointerValues);
+BENCHMARK_HASH_VALUES(PairValues);
+BENCHMARK_HASH_VALUES(TupleValues);
+BENCHMARK_HASH_VALUES(ArrayValues);
+BENCHMARK_HASH_VALUES(DoubleVectorValues);
+BENCHMARK_HASH_VALUES(ForwardListValues);
+BENCHMARK_HASH_VALUES(UniquePtrValues);
+
+// Fixed-size keys
+// ==========================================================================
+//
+// std_::hash hashes keys whose std_::fixed_hash_size is at most 64 bytes
+// with a single fixed-length FarmHash call; farmhash_combine_hasher streams
+// them through hashing::farmhash with hash_combine(), as std_::hash does
+// for other keys, and computes the same value. (farmhash_hasher calls
+// hash_value() directly, which for a uniquely represented tuple hashes the
+// elements one by one rather than the tuple's bytes, and so computes a
+// different value.)
+
+template <typename T>
+struct farmhash_combine_hasher {
+  hashing::farmhash::result_type operator()(const T& t) const {
+    hashing::farmhash::state_type state;
+    return hashing::farmhash::result_type(
+        hash_combine(hashing::farmhash{&state}, t));
+  }
+};
+
+struct IntTripleValues {
+  using type = std::tuple<int, int, int>;
+  static type Make(int i) { return std::make_tuple(i, i >> 4, -i); }
+};
+
+// Not uniquely represented, because of the padding after the uint32_t.
+struct PaddedPairValues {
+  using type = std::pair<uint64_t, uint32_t>;
+  static type Make(int i) { return {uint64_t{1} << (i % 64), i}; }
+};
+
+// 24 bytes.
+struct MixedTupleValues {
+  using type = std::tuple<uint64_t, double, int16_t, char, bool, float>;
+  static type Make(int i) {
+    return std::make_tuple(i, i * 0.5, static_cast<int16_t>(i), 'c',
+                           i % 2 == 0, i * 0.25f);
+  }
+};
+
+// 41 bytes.
+struct WideTupleValues {
+  using type = std::tuple<double, double, double, double, double, bool>;
+  static type Make(int i) {
+    return std::make_tuple(i, i + 1.0, i + 2.0, i + 3.0, i + 4.0, i % 2 == 0);
+  }
+};
+
+#define BENCHMARK_HASH_FIXED_SIZE_VALUES(values)                    \
+  BENCHMARK_TEMPLATE2(BM_HashValues, values,                        \
+                      farmhash_combine_hasher<values::type>);       \
+  BENCHMARK_TEMPLATE2(BM_HashValues, values, std_::hash<values::type>)
+
+BENCHMARK_HASH_FIXED_SIZE_VALUES(IntTripleValues);
+BENCHMARK_HASH_FIXED_SIZE_VALUES(PaddedPairValues);
+BENCHMARK_HASH_FIXED_SIZE_VALUES(MixedTupleValues);
+BENCHMARK_HASH_FIXED_SIZE_VALUES(WideTupleValues);
+BENCHMARK_HASH_FIXED_SIZE_VALUES(DoubleValues);
+
+// std_::hash also hashes strings of up to 56 bytes with a single FarmHash
+// call. The lengths vary, as they would in a real table.
+
+struct ShortStringValues {
+  using type = std::string;
+  static type Make(int i) {
+    return std::string(reinterpret_cast<const char*>(&Bytes()[i]), i % 32);
+  }
+};
+
+struct MediumStringValues {
+  using type = std::string;
+  static type Make(int i) {
+    return std::string(reinterpret_cast<const char*>(&Bytes()[i]),
+                       32 + i % 25);
+  }
+};
+
+BENCHMARK_HASH_FIXED_SIZE_VALUES(ShortStringValues);
+BENCHMARK_HASH_FIXED_SIZE_VALUES(MediumStringValues);
+
+// Multiple hashes per key
+// ==========================================================================
+//
+// Computes K hashes of each string, as a Bloom filter or sketch would, in
+// one pass with multi_hash, and with K farmhash passes seeded by
+// combining the lane index with the key.
+
+template <size_t K>
+struct multi_hasher {
+  std::array<uint64_t, K> operator()(string_piece s) const {
+    typename hashing::multi_hash<K>::state_type state;
+    return typename hashing::multi_hash<K>::result_type(
+        hash_value(hashing::multi_hash<K>{&state}, s));
+  }
+};
+
+template <size_t K>
+struct separate_farmhash_hasher {
+  std::array<uint64_t, K> operator()(string_piece s) const {
+    std::array<uint64_t, K> result;
+    for (size_t i = 0; i < K; ++i) {
+      hashing::farmhash::state_type state;
+      result[i] = hashing::farmhash::result_type(
+          hash_combine(hashing::farmhash{&state}, i, s));
+    }
+    return result;
+  }
+};
+
+#define BENCHMARK_MULTI_HASH(k)                                       \
+  BENCHMARK_TEMPLATE(BM_HashStrings, multi_hasher<k>)                 \
+      ->Arg(8)->Arg(32)->Arg(256)->Arg(4096)->Arg(65536);             \
+  BENCHMARK_TEMPLATE(BM_HashStrings, separate_farmhash_hasher<k>)     \
+      ->Arg(8)->Arg(32)->Arg(256)->Arg(4096)->Arg(65536)
+
+BENCHMARK_MULTI_HASH(2);
+BENCHMARK_MULTI_HASH(4);
+BENCHMARK_MULTI_HASH(8);
+
+// Near-duplicate detection
+// ==========================================================================
+//
+// A synthetic corpus of documents of kDocumentSize words drawn from a
+// vocabulary of kVocabularySize. Every tenth document is a near-duplicate
+// of the one before it, with a few words replaced.
+
+static const int kDocumentSize = 200;
+static const int kVocabularySize = 50000;
+
+static std::vector<std::vector<std::string>> MakeCorpus(int num_documents) {
+  std::default_random_engine engine;
+  std::uniform_int_distribution<int> word(0, kVocabularySize - 1);
+  std::vector<std::vector<std::string>> corpus;
+  for (int i = 0; i < num_documents; ++i) {
+    if (i % 10 == 9) {
+      corpus.push_back(corpus.back());
+      for (int j = 0; j < kDocumentSize / 20; ++j) {
+        corpus.back()[word(engine) % kDocumentSize] =
+            "w" + std::to_string(word(engine));
+      }
+      continue;
+    }
+    corpus.emplace_back();
+    for (int j = 0; j < kDocumentSize; ++j) {
+      corpus.back().push_back("w" + std::to_string(word(engine)));
+    }
+  }
+  return corpus;
+}
+
+template <size_t K>
+static void BM_MinHash(benchmark::State& state) {
+  const auto corpus = MakeCorpus(1000);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        hashing::minhash<K>(corpus[i].begin(), corpus[i].end()));
+    i = (i + 1) % corpus.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kDocumentSize);
+}
+
+BENCHMARK_TEMPLATE(BM_MinHash, 64);
+BENCHMARK_TEMPLATE(BM_MinHash, 128);
+BENCHMARK_TEMPLATE(BM_MinHash, 256);
+
+static void BM_SimHash(benchmark::State& state) {
+  const auto corpus = MakeCorpus(1000);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        hashing::simhash(corpus[i].begin(), corpus[i].end()));
+    i = (i + 1) % corpus.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kDocumentSize);
+}
+
+BENCHMARK(BM_SimHash);
+
+// Finds each document's near-duplicates among range_x() documents, with
+// an lsh_index, and by comparing its signature to every other signature.
+// Both use the same signatures, which are computed in advance.
+
+using CorpusIndex = hashing::lsh_index<32, 4>;
+
+static std::vector<CorpusIndex::signature> CorpusSignatures(int size) {
+  std::vector<CorpusIndex::signature> signatures;
+  for (const auto& document : MakeCorpus(size)) {
+    signatures.push_back(
+        hashing::minhash<128>(document.begin(), document.end()));
+  }
+  return signatures;
+}
+
+static void BM_NearDuplicatesLsh(benchmark::State& state) {
+  const auto signatures = CorpusSignatures(state.range_x());
+  CorpusIndex index;
+  for (size_t i = 0; i < signatures.size(); ++i) {
+    index.insert(i, signatures[i]);
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(index.candidates(signatures[i]));
+    i = (i + 1) % signatures.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_NearDuplicatesBruteForce(benchmark::State& state) {
+  const auto signatures = CorpusSignatures(state.range_x());
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    std::vector<size_t> matches;
+    for (size_t j = 0; j < signatures.size(); ++j) {
+      if (hashing::estimate_jaccard(signatures[i], signatures[j]) >= 0.5) {
+        matches.push_back(j);
+      }
+    }
+    benchmark::DoNotOptimize(matches);
+    i = (i + 1) % signatures.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_NearDuplicatesLsh)->Range(1000, 100000);
+BENCHMARK(BM_NearDuplicatesBruteForce)->Range(1000, 100000);
+
 BENCHMARK_MAIN();
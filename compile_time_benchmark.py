@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+# Copyright 2015 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compile-time benchmark for the hashing templates.
+
+Generates translation units that hash N-field structs and N-element tuples
+with each of the hash algorithms, compiles each one, and reports the
+compiler's wall time (the best of --runs) and peak memory use. This
+measures the cost of the variadic hash_combine/hash_append machinery,
+which is instantiated once per distinct argument list.
+
+  $ ./compile_time_benchmark.py --cxx=clang++ --flags='-std=c++1y -O2'
+"""
+
+import argparse
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+# Field types for the generated structs and tuples, used cyclically. The
+# mix covers the byte-hashing fast path as well as hash_value() recursion.
+FIELD_TYPES = ('int', 'double', 'std::string', 'bool', 'char', 'long long',
+               'std::vector<int>', 'std::pair<int, short>')
+
+PROLOGUE = '''\
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "debug.h"
+#include "fnv1a.h"
+#include "n3980.h"
+#include "n3980-farmhash.h"
+#include "std.h"
+'''
+
+STRUCT_TEMPLATE = PROLOGUE + '''
+struct S {
+%(fields)s
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode code, const S& s) {
+    return hash_combine(std::move(code), %(members)s);
+  }
+
+  template <typename HashAlgorithm>
+  friend void hash_append(HashAlgorithm& h, const S& s) {
+    using std_::hash_append;
+    hash_append(h, %(members)s);
+  }
+};
+
+size_t HashFarmhash(const S& s) { return std_::hash<S>()(s); }
+
+size_t HashFnv1a(const S& s) {
+  return hashing::fnv1a::result_type(hash_value(hashing::fnv1a(), s));
+}
+
+size_t HashTypeInvariantFnv1a(const S& s) {
+  return hashing::type_invariant_fnv1a::result_type(
+      hash_value(hashing::type_invariant_fnv1a(), s));
+}
+
+std::string HashIdentity(const S& s) {
+  return hashing::identity::result_type(hash_value(hashing::identity(), s));
+}
+
+size_t HashN3980(const S& s) {
+  return std_::uhash<hashing::n3980::farmhash>()(s);
+}
+'''
+
+TUPLE_TEMPLATE = PROLOGUE + '''
+using T = std::tuple<%(types)s>;
+
+bool IsUniquelyRepresented() {
+  return std_::is_uniquely_represented<T>::value;
+}
+
+size_t HashFarmhash(const T& t) { return std_::hash<T>()(t); }
+
+size_t HashFnv1a(const T& t) {
+  using std_::hash_value;
+  return hashing::fnv1a::result_type(hash_value(hashing::fnv1a(), t));
+}
+
+size_t HashTypeInvariantFnv1a(const T& t) {
+  using std_::hash_value;
+  return hashing::type_invariant_fnv1a::result_type(
+      hash_value(hashing::type_invariant_fnv1a(), t));
+}
+
+size_t HashN3980(const T& t) {
+  return std_::uhash<hashing::n3980::farmhash>()(t);
+}
+'''
+
+
+def generate(kind, n):
+  """Returns the source of a translation unit of the given kind and size."""
+  if kind == 'struct':
+    fields = ''.join('  %s f%d;\n' % (FIELD_TYPES[i % len(FIELD_TYPES)], i)
+                     for i in range(n))
+    members = ', '.join('s.f%d' % i for i in range(n))
+    return STRUCT_TEMPLATE % {'fields': fields, 'members': members}
+  if kind == 'tuple':
+    types = ', '.join(FIELD_TYPES[i % len(FIELD_TYPES)] for i in range(n))
+  else:  # 'int_tuple', which is uniquely represented
+    types = ', '.join(['int'] * n)
+  return TUPLE_TEMPLATE % {'types': types}
+
+
+def compile_once(command):
+  """Runs 'command' and returns (seconds, peak RSS in MiB), or None if the
+  compilation failed."""
+  start = time.perf_counter()
+  process = subprocess.Popen(command, stderr=subprocess.DEVNULL)
+  _, status, usage = os.wait4(process.pid, 0)
+  elapsed = time.perf_counter() - start
+  process.returncode = status  # Already reaped; stop Popen waiting again.
+  if status != 0:
+    return None
+  # ru_maxrss is in KiB on Linux.
+  return elapsed, usage.ru_maxrss / 1024.0
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument('--cxx', default=os.environ.get('CXX', 'c++'),
+                      help='C++ compiler (default: %(default)s)')
+  parser.add_argument('--flags', default='-std=c++1y -O2',
+                      help='compiler flags (default: %(default)s)')
+  parser.add_argument('--include_dir', default=os.path.dirname(
+      os.path.abspath(__file__)), help='directory containing the headers')
+  parser.add_argument('--sizes', default='8,32,128,256',
+                      help='comma-separated field counts (default: '
+                      '%(default)s)')
+  parser.add_argument('--kinds', default='struct,tuple,int_tuple',
+                      help='comma-separated kinds of TU to generate '
+                      '(default: %(default)s)')
+  parser.add_argument('--runs', type=int, default=3,
+                      help='compilations of each TU (default: %(default)s)')
+  args = parser.parse_args()
+
+  sizes = [int(n) for n in args.sizes.split(',')]
+  kinds = args.kinds.split(',')
+  work_dir = tempfile.mkdtemp()
+  print('%-10s %6s %10s %10s' % ('Kind', 'N', 'Time (s)', 'Peak MiB'))
+  sys.stdout.flush()
+  failed = False
+  for kind in kinds:
+    for n in sizes:
+      source = os.path.join(work_dir, '%s_%d.cc' % (kind, n))
+      with open(source, 'w') as f:
+        f.write(generate(kind, n))
+      command = ([args.cxx] + shlex.split(args.flags) +
+                 ['-I', args.include_dir, '-c', source,
+                  '-o', os.devnull])
+      results = [compile_once(command) for _ in range(args.runs)]
+      if None in results:
+        print('%-10s %6d %10s %10s' % (kind, n, 'failed', '-'))
+        failed = True
+      else:
+        print('%-10s %6d %10.2f %10.1f' %
+              (kind, n, min(r[0] for r in results),
+               max(r[1] for r in results)))
+      sys.stdout.flush()
+      os.remove(source)
+  os.rmdir(work_dir)
+  return 1 if failed else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
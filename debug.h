@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifndef HASHING_DEMO_DEBUG_H
+#define HASHING_DEMO_DEBUG_H
+
+#include <array>
+#include <cstddef>
+#include <ostream>
 #include <string>
 
 #include "std.h"
@@ -31,21 +37,10 @@ class identity {
   identity(identity&&) = default;
   identity& operator=(identity&&) = default;
 
-  template <typename T, typename... Ts>
-  friend identity hash_combine(
-      identity code, const T& value, const Ts&... values) {
-    using std_::hash_value;
-    return hash_combine(hash_value(std::move(code), value), values...);
-  }
-
   template <typename... Ts>
-  friend identity hash_combine(
-      identity code, unsigned char c, const Ts&... values) {
-    code.hash_input_.push_back(c);
-    return hash_combine(std::move(code), values...);
-  }
-
-  friend identity hash_combine(identity code) {
+  friend identity hash_combine(identity code, const Ts&... values) {
+    (void)std_::detail::expand{
+        0, (code = combine_one(std::move(code), values), 0)...};
     return std::move(code);
   }
 
@@ -69,9 +64,153 @@ class identity {
   explicit operator result_type() && {
     return result_type(std::move(hash_input_));
   }
+
+ private:
+  template <typename T>
+  static identity combine_one(identity code, const T& value) {
+    using std_::hash_value;
+    return hash_value(std::move(code), value);
+  }
+
+  static identity combine_one(identity code, unsigned char c) {
+    code.hash_input_.push_back(c);
+    return std::move(code);
+  }
+};
+
+// Statistics about the input that a profiling<HashCode> has seen. All counts
+// refer to byte-level hash_combine_range() calls, i.e. the calls that
+// actually feed bytes to the underlying algorithm.
+struct hash_profile {
+  // Number of byte-level calls, and the total bytes they contained.
+  size_t calls = 0;
+  size_t bytes = 0;
+
+  // Calls made on behalf of a single element of a range that could not be
+  // hashed as bytes, so that hash_combine_range() had to fall back to
+  // visiting the elements one at a time. Every other call is a bulk call,
+  // including a contiguous range hashed as bytes within such an element
+  // (e.g. the characters of each string in a vector<string>): its bytes
+  // arrive in one piece, so only the calls around it are fragmented.
+  size_t per_element_calls = 0;
+
+  // size_histogram[0] counts empty calls, and size_histogram[i] counts
+  // calls of [2^(i-1), 2^i) bytes. The last bucket also counts all larger
+  // calls.
+  std::array<size_t, 18> size_histogram = {};
+
+  size_t bulk_calls() const { return calls - per_element_calls; }
+
+  // Writes a human-readable summary of the statistics to 'out'.
+  void report(std::ostream& out) const;
+
+ private:
+  template <typename HashCode>
+  friend class profiling;
+
+  // Nesting depth of per-element fallbacks currently in progress, or 0
+  // within a range that is hashed as bytes.
+  int fallback_depth = 0;
 };
 
+inline void hash_profile::report(std::ostream& out) const {
+  out << "hash_combine_range calls: " << calls
+      << " (" << bulk_calls() << " bulk, "
+      << per_element_calls << " per-element)\n";
+  out << "bytes: " << bytes;
+  if (calls > 0) {
+    out << " (" << static_cast<double>(bytes) / calls << " per call)";
+  }
+  out << "\n";
+  for (size_t i = 0; i < size_histogram.size(); ++i) {
+    if (size_histogram[i] == 0) continue;
+    if (i == 0) {
+      out << "  0 bytes: ";
+    } else if (i == size_histogram.size() - 1) {
+      out << "  >= " << (size_t{1} << (i - 1)) << " bytes: ";
+    } else {
+      out << "  [" << (size_t{1} << (i - 1)) << ", " << (size_t{1} << i)
+          << ") bytes: ";
+    }
+    out << size_histogram[i] << "\n";
+  }
+}
+
+// HashCode that wraps another HashCode and records statistics about how
+// its input arrives, without changing the resulting hash value. Unlike
+// identity, it does not retain the input, so its overhead is a few counter
+// updates per call. This is meant for finding types whose hash_value()
+// overloads feed the algorithm many small, fragmented pieces of input.
+//
+// The hash_profile is not synchronized, so concurrent hashes should use
+// separate profiles.
+template <typename HashCode>
+class profiling {
+  HashCode code_;
+  hash_profile* profile_;
+
+  // Notes the start of a nested range, and returns the fallback depth to
+  // restore at its end.
+  int enter_range(bool per_element) {
+    const int depth = profile_->fallback_depth;
+    profile_->fallback_depth = per_element ? depth + 1 : 0;
+    return depth;
+  }
+
+  void leave_range(int depth) { profile_->fallback_depth = depth; }
+
+  // Records a byte-level call of 'size' bytes.
+  void record(size_t size) {
+    ++profile_->calls;
+    profile_->bytes += size;
+    if (profile_->fallback_depth > 0) ++profile_->per_element_calls;
+    size_t bucket = 0;
+    while (bucket + 1 < profile_->size_histogram.size() &&
+           (size >> bucket) != 0) {
+      ++bucket;
+    }
+    ++profile_->size_histogram[bucket];
+  }
+
+ public:
+  using result_type = typename HashCode::result_type;
 
+  profiling(HashCode code, hash_profile* profile)
+      : code_(std::move(code)), profile_(profile) {}
 
+  profiling(const profiling&) = delete;
+  profiling& operator=(const profiling&) = delete;
+  profiling(profiling&&) = default;
+  profiling& operator=(profiling&&) = default;
+
+  template <typename... Ts>
+  friend profiling hash_combine(profiling code, const Ts&... values) {
+    return std_::simple_hash_combine(std::move(code), values...);
+  }
+
+  template <typename InputIterator>
+  friend profiling hash_combine_range(
+      profiling code, InputIterator begin, InputIterator end) {
+    constexpr bool per_element =
+        !std_::detail::can_hash_range_as_bytes<InputIterator>::value;
+    const int depth = code.enter_range(per_element);
+    code = std_::simple_hash_combine_range(std::move(code), begin, end);
+    code.leave_range(depth);
+    return code;
+  }
+
+  friend profiling hash_combine_range(
+      profiling code, const unsigned char* begin, const unsigned char* end) {
+    code.record(end - begin);
+    code.code_ = hash_combine_range(std::move(code.code_), begin, end);
+    return code;
+  }
+
+  explicit operator result_type() && {
+    return result_type(std::move(code_));
+  }
+};
 
 }  // namespace hashing
+
+#endif  // HASHING_DEMO_DEBUG_H
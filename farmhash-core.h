@@ -0,0 +1,343 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The FarmHash kernel shared by all FarmHash implementations in this
+// directory (farmhash.h, n3980-farmhash.h and farmhash-direct.h), based on
+// farmhashna::Hash64() from https://code.google.com/p/farmhash by Geoff
+// Pike. The implementations differ only in how input reaches the kernel,
+// so benchmarks comparing them measure API overhead alone, and
+// optimizations made here apply to all of them.
+
+#ifndef HASHING_DEMO_FARMHASH_CORE_H
+#define HASHING_DEMO_FARMHASH_CORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace hashing {
+namespace farmhash_core {
+
+// Some primes between 2^63 and 2^64 for various uses.
+static constexpr uint64_t k0 = 0xc3a5c85c97cb3127ULL;
+static constexpr uint64_t k1 = 0xb492b66fbe98f273ULL;
+static constexpr uint64_t k2 = 0x9ae16a3b2f90404fULL;
+
+static constexpr uint64_t kSeed = 81;
+
+// Misc. low-level hashing utilities.
+// ==========================================================================
+
+inline uint64_t Fetch64(const unsigned char* p) {
+  uint64_t result;
+  memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint32_t Fetch32(const unsigned char* p) {
+  uint32_t result;
+  memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint64_t Rotate(uint64_t val, int shift) {
+  // Avoid shifting by 64: doing so yields an undefined result.
+  return shift == 0 ? val : ((val >> shift) | (val << (64 - shift)));
+}
+
+inline uint64_t ShiftMix(uint64_t val) {
+  return val ^ (val >> 47);
+}
+
+inline uint64_t HashLen16(uint64_t u, uint64_t v, uint64_t mul) {
+  // Murmur-inspired hashing.
+  uint64_t a = (u ^ v) * mul;
+  a ^= (a >> 47);
+  uint64_t b = (v ^ a) * mul;
+  b ^= (b >> 47);
+  b *= mul;
+  return b;
+}
+
+// Hashing of inputs of at most 64 bytes
+// ==========================================================================
+
+inline uint64_t HashLen0to16(const unsigned char* s, size_t len) {
+  if (len >= 8) {
+    uint64_t mul = k2 + len * 2;
+    uint64_t a = Fetch64(s) + k2;
+    uint64_t b = Fetch64(s + len - 8);
+    uint64_t c = Rotate(b, 37) * mul + a;
+    uint64_t d = (Rotate(a, 25) + b) * mul;
+    return HashLen16(c, d, mul);
+  }
+  if (len >= 4) {
+    uint64_t mul = k2 + len * 2;
+    uint64_t a = Fetch32(s);
+    return HashLen16(len + (a << 3), Fetch32(s + len - 4), mul);
+  }
+  if (len > 0) {
+    uint8_t a = s[0];
+    uint8_t b = s[len >> 1];
+    uint8_t c = s[len - 1];
+    uint32_t y = static_cast<uint32_t>(a) + (static_cast<uint32_t>(b) << 8);
+    uint32_t z = len + (static_cast<uint32_t>(c) << 2);
+    return ShiftMix(y * k2 ^ z * k0) * k2;
+  }
+  return k2;
+}
+
+// This probably works well for 16-byte strings as well, but it may be overkill
+// in that case.
+inline uint64_t HashLen17to32(const unsigned char* s, size_t len) {
+  uint64_t mul = k2 + len * 2;
+  uint64_t a = Fetch64(s) * k1;
+  uint64_t b = Fetch64(s + 8);
+  uint64_t c = Fetch64(s + len - 8) * mul;
+  uint64_t d = Fetch64(s + len - 16) * k2;
+  return HashLen16(Rotate(a + b, 43) + Rotate(c, 30) + d,
+                   a + Rotate(b + k2, 18) + c, mul);
+}
+
+// Return an 8-byte hash for 33 to 64 bytes.
+inline uint64_t HashLen33to64(const unsigned char* s, size_t len) {
+  uint64_t mul = k2 + len * 2;
+  uint64_t a = Fetch64(s) * k2;
+  uint64_t b = Fetch64(s + 8);
+  uint64_t c = Fetch64(s + len - 8) * mul;
+  uint64_t d = Fetch64(s + len - 16) * k2;
+  uint64_t y = Rotate(a + b, 43) + Rotate(c, 30) + d;
+  uint64_t z = HashLen16(y, a + Rotate(b + k2, 18) + c, mul);
+  uint64_t e = Fetch64(s + 16) * mul;
+  uint64_t f = Fetch64(s + 24);
+  uint64_t g = (y + Fetch64(s + len - 32)) * mul;
+  uint64_t h = (z + Fetch64(s + len - 24)) * mul;
+  return HashLen16(Rotate(e + f, 43) + Rotate(g, 30) + h,
+                   e + Rotate(f + a, 18) + g, mul);
+}
+
+inline uint64_t HashLen0to64(const unsigned char* s, size_t len) {
+  if (len <= 32) {
+    if (len <= 16) {
+      return HashLen0to16(s, len);
+    } else {
+      return HashLen17to32(s, len);
+    }
+  } else {
+    return HashLen33to64(s, len);
+  }
+}
+
+// Equivalent to HashLen0to64(s, Len), but chooses the function for the
+// length at compile time. The last parameter is a dispatching tag for
+// that choice.
+template <size_t Len>
+uint64_t HashFixedLen(const unsigned char* s,
+                      std::integral_constant<int, 16>) {
+  return HashLen0to16(s, Len);
+}
+
+template <size_t Len>
+uint64_t HashFixedLen(const unsigned char* s,
+                      std::integral_constant<int, 32>) {
+  return HashLen17to32(s, Len);
+}
+
+template <size_t Len>
+uint64_t HashFixedLen(const unsigned char* s,
+                      std::integral_constant<int, 64>) {
+  return HashLen33to64(s, Len);
+}
+
+template <size_t Len>
+uint64_t HashFixedLen(const unsigned char* s) {
+  static_assert(Len <= 64, "HashFixedLen requires at most 64 bytes");
+  return HashFixedLen<Len>(
+      s, std::integral_constant<int, Len <= 16 ? 16 : Len <= 32 ? 32 : 64>());
+}
+
+// Hashing of inputs of more than 64 bytes
+// ==========================================================================
+
+// Return a 16-byte hash for s[0] ... s[31], a, and b.  Quick and dirty.
+inline std::pair<uint64_t, uint64_t> WeakHashLen32WithSeeds(
+    const unsigned char* s, uint64_t a, uint64_t b) {
+  const uint64_t w = Fetch64(s);
+  const uint64_t x = Fetch64(s + 8);
+  const uint64_t y = Fetch64(s + 16);
+  const uint64_t z = Fetch64(s + 24);
+  a += w;
+  b = Rotate(b + a + z, 21);
+  uint64_t c = a;
+  a += x;
+  a += y;
+  b += Rotate(a, 44);
+  return {a + z, b + c};
+}
+
+// The 56 bytes of state that FarmHash carries between 64-byte blocks. This
+// is a plain value type, so callers can copy it into a local variable
+// around a loop of mix() calls; the optimizer can then keep it in
+// registers, which it cannot do for state that the input might alias.
+struct mixing_state {
+  uint64_t x;
+  uint64_t y;
+  uint64_t z;
+  std::pair<uint64_t, uint64_t> v;
+  std::pair<uint64_t, uint64_t> w;
+
+  // Initializes the state. 's' points to the first block of input.
+  void initialize(const unsigned char* s) {
+    x = kSeed;
+    y = kSeed * k1 + 113;
+    z = ShiftMix(y * k2 + 113) * k2;
+    v = {0, 0};
+    w = {0, 0};
+    x = x * k2 + Fetch64(s);
+  }
+
+  // Mixes the 64-byte block at 's', which need not be aligned. Every block
+  // except the last is mixed this way, including the first.
+  void mix(const unsigned char* s) {
+    x = Rotate(x + y + v.first + Fetch64(s + 8), 37) * k1;
+    y = Rotate(y + v.second + Fetch64(s + 48), 42) * k1;
+    x ^= w.second;
+    y += v.first + Fetch64(s + 40);
+    z = Rotate(z + w.first, 33) * k1;
+    v = WeakHashLen32WithSeeds(s, v.second * k1, x + w.first);
+    w = WeakHashLen32WithSeeds(s + 32, z + w.second, y + Fetch64(s + 16));
+    std::swap(z, x);
+  }
+
+  // Computes the hash value. 's' points to the last 64 bytes of input, in
+  // order, and 'len' is the total input length, of which only
+  // (len - 1) % 64 matters.
+  uint64_t final_mix(const unsigned char* s, size_t len) {
+    uint64_t mul = k1 + ((z & 0xff) << 1);
+    w.first += ((len - 1) & 63);
+    v.first += w.first;
+    w.first += v.first;
+    x = Rotate(x + y + v.first + Fetch64(s + 8), 37) * mul;
+    y = Rotate(y + v.second + Fetch64(s + 48), 42) * mul;
+    x ^= w.second * 9;
+    y += v.first * 9 + Fetch64(s + 40);
+    z = Rotate(z + w.first, 33) * mul;
+    v = WeakHashLen32WithSeeds(s, v.second * mul, x + w.first);
+    w = WeakHashLen32WithSeeds(s + 32, z + w.second, y + Fetch64(s + 16));
+    std::swap(z, x);
+    return HashLen16(HashLen16(v.first, w.first, mul) + ShiftMix(y) * k0 + z,
+                     HashLen16(v.second, w.second, mul) + x,
+                     mul);
+  }
+};
+
+// Mixes the 64-byte blocks starting at 'begin' until 1 to 64 bytes remain
+// before 'end', and returns a pointer to the remainder.
+// Precondition: end - begin > 64.
+inline const unsigned char* mix_blocks(
+    mixing_state* state, const unsigned char* begin,
+    const unsigned char* end) {
+  mixing_state local = *state;
+  do {
+    local.mix(begin);
+    begin += 64;
+  } while (end - begin > 64);
+  *state = local;
+  return begin;
+}
+
+// Hashes the contiguous input [s, s + len) in one pass.
+inline uint64_t Hash64(const unsigned char* s, size_t len) {
+  if (len <= 64) {
+    return HashLen0to64(s, len);
+  }
+  mixing_state state;
+  state.initialize(s);
+  const unsigned char* const end = s + len;
+  mix_blocks(&state, s, end);
+  return state.final_mix(end - 64, len);
+}
+
+// Support for streaming implementations
+// ==========================================================================
+//
+// Streaming implementations keep a 64-byte buffer that holds the input not
+// yet mixed. The buffer acts as a circular buffer: after the first block
+// has been mixed, buffer[0, n) holds the n unmixed bytes, and buffer[n, 64)
+// holds the tail of the previous block, which final_mix() also reads. n
+// is always at least 1, because the last block must be left for
+// final_mix(). 'mixed' indicates whether any block has been mixed, i.e.
+// whether 'state' is initialized.
+
+// Adds [begin, end) to the input. 'buffer_next' points just past the
+// unmixed bytes in 'buffer'.
+inline void buffered_append(
+    mixing_state* state, unsigned char* buffer, unsigned char** buffer_next,
+    bool* mixed, const unsigned char* begin, const unsigned char* end) {
+  const size_t buffer_remaining = buffer + 64 - *buffer_next;
+  if (static_cast<size_t>(end - begin) <= buffer_remaining) {
+    // The input will not saturate the buffer, so we just copy it.
+    memcpy(*buffer_next, begin, end - begin);
+    *buffer_next += end - begin;
+    return;
+  }
+
+  // Fill the buffer and mix it.
+  memcpy(*buffer_next, begin, buffer_remaining);
+  begin += buffer_remaining;
+  if (!*mixed) {
+    state->initialize(buffer);
+    *mixed = true;
+  }
+  state->mix(buffer);
+
+  if (end - begin <= 64) {
+    memcpy(buffer, begin, end - begin);
+    *buffer_next = buffer + (end - begin);
+    return;
+  }
+
+  // Mix whole blocks directly from the input, without copying them into
+  // the buffer. Then buffer the unmixed bytes, followed by the tail of the
+  // last mixed block, which ends where the unmixed bytes begin. (Copying
+  // it from there rather than from end - 64 lets the compiler see that it
+  // is within the input.)
+  begin = mix_blocks(state, begin, end);
+  const size_t unmixed = end - begin;
+  memcpy(buffer, begin, unmixed);
+  memcpy(buffer + unmixed, begin - (64 - unmixed), 64 - unmixed);
+  *buffer_next = buffer + unmixed;
+}
+
+// Computes the hash value of the buffered input. 'len' is the number of
+// unmixed bytes in 'buffer'. This rotates the buffer in place.
+inline uint64_t buffered_finish(
+    mixing_state* state, unsigned char* buffer, size_t len, bool mixed) {
+  if (!mixed) {
+    // The buffer contains the entire input.
+    return HashLen0to64(buffer, len);
+  }
+  // final_mix() reads the last 64 bytes of input in order, so rotate the
+  // circular buffer to put them in order.
+  std::rotate(buffer, buffer + len, buffer + 64);
+  return state->final_mix(buffer, len);
+}
+
+}  // namespace farmhash_core
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_FARMHASH_CORE_H
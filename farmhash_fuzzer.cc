@@ -0,0 +1,160 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Differential fuzzer for the streaming FarmHash implementations. The
+// input is split into a sequence of chunks, which are fed one at a time
+// to hashing::farmhash (via hash_combine_range) and hashing::n3980::farmhash
+// (via operator()). Both must agree with direct::farmhash::Hash64 on the
+// whole input, however it is split.
+//
+// Built with -Denable_libfuzzer=ON, this is a libFuzzer target. Otherwise
+// it is a standalone program that replays the inputs named on its command
+// line, or if there are none, runs a fixed number of pseudo-random inputs.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "farmhash.h"
+#include "farmhash-direct.h"
+#include "n3980-farmhash.h"
+
+namespace {
+
+// Splits 'data' into a chunk-length schedule and a message. The first byte
+// gives the number of schedule bytes that follow it (at most 16), and each
+// schedule byte is the length of a chunk. The schedule is repeated until
+// the message is exhausted, so short schedules still cover long messages.
+struct Input {
+  std::vector<size_t> chunk_lengths;
+  const unsigned char* message;
+  size_t message_length;
+
+  Input(const uint8_t* data, size_t size) {
+    size_t schedule_length = 0;
+    if (size > 0) {
+      schedule_length = std::min<size_t>(data[0] % 17, size - 1);
+      ++data;
+      --size;
+    }
+    bool all_empty = true;
+    for (size_t i = 0; i < schedule_length; ++i) {
+      chunk_lengths.push_back(data[i]);
+      all_empty &= (data[i] == 0);
+    }
+    // A schedule of only empty chunks would never make progress, so
+    // finish with a single chunk holding the whole message.
+    if (all_empty) chunk_lengths.push_back(size);
+    message = data + schedule_length;
+    message_length = size - schedule_length;
+  }
+
+  // Calls f(begin, end) for each chunk of the message, in order.
+  template <typename F>
+  void ForEachChunk(F f) const {
+    const unsigned char* begin = message;
+    const unsigned char* const end = message + message_length;
+    for (size_t i = 0; begin != end; i = (i + 1) % chunk_lengths.size()) {
+      const size_t length = std::min<size_t>(chunk_lengths[i], end - begin);
+      f(begin, begin + length);
+      begin += length;
+    }
+  }
+};
+
+void Fail(const char* implementation, const Input& input, uint64_t expected,
+          uint64_t actual) {
+  fprintf(stderr, "%s mismatch for %zu-byte message split as [",
+          implementation, input.message_length);
+  for (size_t length : input.chunk_lengths) {
+    fprintf(stderr, " %zu", length);
+  }
+  fprintf(stderr, " ]: expected %016llx, got %016llx\n",
+          static_cast<unsigned long long>(expected),
+          static_cast<unsigned long long>(actual));
+  abort();
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const Input input(data, size);
+  const uint64_t expected = hashing::direct::farmhash::Hash64(
+      reinterpret_cast<const char*>(input.message), input.message_length);
+
+  hashing::farmhash::state_type state;
+  hashing::farmhash hash_code(&state);
+  input.ForEachChunk([&](const unsigned char* begin, const unsigned char* end) {
+    hash_code = hash_combine_range(std::move(hash_code), begin, end);
+  });
+  const uint64_t actual = hashing::farmhash::result_type(std::move(hash_code));
+  if (actual != expected) Fail("hashing::farmhash", input, expected, actual);
+
+  hashing::n3980::farmhash h;
+  input.ForEachChunk([&](const unsigned char* begin, const unsigned char* end) {
+    h(begin, end - begin);
+  });
+  const uint64_t n3980_actual = static_cast<size_t>(h);
+  if (n3980_actual != expected) {
+    Fail("hashing::n3980::farmhash", input, expected, n3980_actual);
+  }
+  return 0;
+}
+
+#ifndef HASHING_DEMO_LIBFUZZER
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      std::ifstream file(argv[i], std::ios::binary);
+      const std::vector<uint8_t> data{std::istreambuf_iterator<char>(file),
+                                      std::istreambuf_iterator<char>()};
+      LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+    return 0;
+  }
+
+  // Inputs up to a few times the 64-byte block size exercise every buffer
+  // boundary case, with occasional longer ones to cover many mix() calls.
+  static const int kIterations = 20000;
+  std::default_random_engine engine;
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<size_t> short_size(0, 300);
+  std::uniform_int_distribution<size_t> long_size(0, 5000);
+  std::vector<uint8_t> data;
+  for (int i = 0; i < kIterations; ++i) {
+    data.resize(i % 10 == 0 ? long_size(engine) : short_size(engine));
+    for (uint8_t& b : data) {
+      b = byte(engine);
+    }
+    // Bias the schedule towards short chunks, which hit the most
+    // interesting boundary cases.
+    if (data.size() > 1 && i % 2 == 0) {
+      for (size_t j = 1; j <= data[0] % 17 && j < data.size(); ++j) {
+        data[j] %= 80;
+      }
+    }
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+  }
+  printf("%d inputs OK\n", kIterations);
+  return 0;
+}
+
+#endif  // HASHING_DEMO_LIBFUZZER
@@ -13,14 +13,65 @@
 // limitations under the License.
 
 // Golden tests of farmhash, based on tests in original FarmHash source.
+// Every FarmHash implementation in this directory is checked against the
+// same golden values. The test cases are independent, so they are divided
+// into shards, which gtest can distribute across processes (via
+// GTEST_TOTAL_SHARDS and GTEST_SHARD_INDEX), and each shard checks its
+// cases on all available hardware threads.
 
+#include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/mman.h>
+#endif
+
+#include "gtest/gtest.h"
 
 #include "farmhash.h"
+#include "farmhash-direct.h"
+#include "n3980-farmhash.h"
 #include "std.h"
 
-namespace farmhashna {
+namespace {
+
+// A FarmHash implementation under test, adapted to the API of
+// farmhashna::Hash64() from the original FarmHash source.
+struct Implementation {
+  const char* name;
+  uint64_t (*hash64)(const char* s, size_t len);
+};
+
+uint64_t FrameworkHash64(const char* s, size_t len) {
+  hashing::farmhash::state_type state;
+  return static_cast<size_t>(
+      hash_combine_range(hashing::farmhash(&state), s, s + len));
+}
+
+uint64_t N3980Hash64(const char* s, size_t len) {
+  hashing::n3980::farmhash h;
+  h(s, len);
+  return static_cast<size_t>(h);
+}
+
+uint64_t DirectHash64(const char* s, size_t len) {
+  return hashing::direct::farmhash::Hash64(s, len);
+}
+
+// New implementations (e.g. optimized or SIMD variants) should be added
+// here, so that they are held to the same golden values.
+const Implementation kImplementations[] = {
+  {"framework", &FrameworkHash64},
+  {"n3980", &N3980Hash64},
+  {"direct", &DirectHash64},
+};
 
 uint64_t HashLen16(uint64_t u, uint64_t v) {
   static constexpr uint64_t kMul = 0x9ddfea08eb382d69ULL;
@@ -32,42 +83,22 @@ uint64_t HashLen16(uint64_t u, uint64_t v) {
   return b;
 }
 
-// Adapt our API to the one the test fixture expects
-uint64_t Hash64(const char* str, size_t len) {
-  hashing::farmhash::state_type state;
-  return static_cast<size_t>(
-      hash_combine_range(hashing::farmhash(&state), str, str + len));
-}
-
-uint64_t Hash64WithSeeds(const char *s, size_t len,
-                         uint64_t seed0, uint64_t seed1) {
-  return HashLen16(Hash64(s, len) - seed0, seed1);
+uint64_t Hash64WithSeeds(const Implementation& impl, const char *s,
+                         size_t len, uint64_t seed0, uint64_t seed1) {
+  return HashLen16(impl.hash64(s, len) - seed0, seed1);
 }
 
-uint64_t Hash64WithSeed(const char *s, size_t len,
-                        uint64_t seed) {
+uint64_t Hash64WithSeed(const Implementation& impl, const char *s,
+                        size_t len, uint64_t seed) {
   static constexpr uint64_t k2 = 0x9ae16a3b2f90404fULL;
-  return Hash64WithSeeds(s, len, k2, seed);
+  return Hash64WithSeeds(impl, s, len, k2, seed);
 }
 
-}  // namespace farmhashna
-
-using std::cout;
-using std::cerr;
-using std::endl;
-using std::hex;
-
 constexpr int kDataSize = 1 << 20;
 static const int kTestSize = 300;
 
 char data[kDataSize];
 
-int errors = 0;
-
-template <typename T> constexpr bool IsNonZero(T x) {
-  return x != 0;
-}
-
 // Initialize data to pseudorandom values.
 void Setup() {
   static constexpr uint64_t k0 = 0xc3a5c85c97cb3127ULL;
@@ -102,14 +133,7 @@ uint32_t CreateSeed(int offset, int salt) {
   return h;
 }
 
-#undef SEED
-#undef SEED1
-#undef SEED0
-#define SEED CreateSeed(offset, -1)
-#define SEED0 CreateSeed(offset, 0)
-#define SEED1 CreateSeed(offset, 1)
-
-uint32_t expected[] = {
+const uint32_t expected[] = {
 1140953930u, 861465670u,
 3277735313u, 2681724312u,
 2598464059u, 797982799u,
@@ -1198,60 +1222,135 @@ uint32_t expected[] = {
 4166253320u, 2747410691u,
 };
 
-// Return false only if offset is -1 and a spot check of 3 hashes all yield 0.
-bool Test(int offset, int len = 0) {
-#undef Check
-#undef IsAlive
-
-#define Check(x) do {                                                   \
-  const uint32_t actual = (x), e = expected[index++];                   \
-  bool ok = actual == e;                                                \
-  if (!ok) {                                                            \
-    cerr << "expected " << hex << e << " but got " << actual << endl;   \
-    ++errors;                                                           \
-  }                                                                     \
-  assert(ok);                                                           \
-} while (0)
+// Each test case checks three hashes of data[offset, offset + len), and
+// each hash contributes two values (its high and low halves) to expected[].
+constexpr int kValuesPerCase = 6;
 
-#define IsAlive(x) do { alive += IsNonZero(x); } while (0)
-
-  // After the following line is where the uses of "Check" and such will go.
-  static int index = 0;
-if (offset == -1) { int alive = 0; { uint64_t h = farmhashna::Hash64WithSeeds(data, len++, SEED0, SEED1); IsAlive(h >> 32); IsAlive((h << 32) >> 32); } { uint64_t h = farmhashna::Hash64WithSeed(data, len++, SEED); IsAlive(h >> 32); IsAlive((h << 32) >> 32); } { uint64_t h = farmhashna::Hash64(data, len++); IsAlive(h >> 32); IsAlive((h << 32) >> 32); } len -= 3; return alive > 0; }
-{ uint64_t h = farmhashna::Hash64WithSeeds(data + offset, len, SEED0, SEED1); Check(h >> 32); Check((h << 32) >> 32); }
-{ uint64_t h = farmhashna::Hash64WithSeed(data + offset, len, SEED); Check(h >> 32); Check((h << 32) >> 32); }
-{ uint64_t h = farmhashna::Hash64(data + offset, len); Check(h >> 32); Check((h << 32) >> 32); }
-
-  return true;
-#undef Check
-#undef IsAlive
-}
+struct TestCase {
+  int offset;
+  int len;
+};
 
-int RunTest() {
-  Setup();
+// Returns the test cases in the order of their values in expected[].
+std::vector<TestCase> TestCases() {
+  std::vector<TestCase> cases;
   int i = 0;
-  cout << "Running farmhashnaTest";
-  if (!Test(-1)) {
-    cout << "... Unavailable\n";
-    return errors;
-  }
-  // Good.  The function is attempting to hash, so run the full test.
-  int errors_prior_to_test = errors;
   for ( ; i < kTestSize - 1; i++) {
-    Test(i * i, i);
+    cases.push_back({i * i, i});
   }
   for ( ; i < kDataSize; i += i / 7) {
-    Test(0, i);
+    cases.push_back({0, i});
+  }
+  cases.push_back({0, kDataSize});
+  assert(cases.size() * kValuesPerCase == sizeof(expected) / sizeof(*expected));
+  return cases;
+}
+
+// Checks test case number 'index', and returns a description of each
+// value that does not match.
+std::vector<std::string> Check(const Implementation& impl, int index,
+                               const TestCase& test_case) {
+  const int offset = test_case.offset;
+  const int len = test_case.len;
+  const char* s = data + offset;
+  const uint64_t hashes[] = {
+    Hash64WithSeeds(impl, s, len, CreateSeed(offset, 0),
+                    CreateSeed(offset, 1)),
+    Hash64WithSeed(impl, s, len, CreateSeed(offset, -1)),
+    impl.hash64(s, len),
+  };
+  std::vector<std::string> errors;
+  const uint32_t* e = expected + index * kValuesPerCase;
+  for (uint64_t h : hashes) {
+    for (uint32_t actual : {uint32_t(h >> 32), uint32_t((h << 32) >> 32)}) {
+      if (actual != *e) {
+        errors.push_back("offset " + std::to_string(offset) + ", len " +
+                         std::to_string(len) + ": expected " +
+                         std::to_string(*e) + " but got " +
+                         std::to_string(actual));
+      }
+      ++e;
+    }
   }
-  Test(0, kDataSize);
-  cout << (errors == errors_prior_to_test ? "... OK\n" : "... Failed\n");
   return errors;
 }
 
-#undef SEED
-#undef SEED1
-#undef SEED0
+constexpr int kNumShards = 8;
+
+class FarmhashGoldenTest
+    : public ::testing::TestWithParam<std::tuple<Implementation, int>> {
+ public:
+  static void SetUpTestCase() { ::Setup(); }
+};
+
+TEST_P(FarmhashGoldenTest, MatchesGoldenValues) {
+  const Implementation& impl = std::get<0>(GetParam());
+  const int shard = std::get<1>(GetParam());
+
+  static const std::vector<TestCase> cases = TestCases();
+  std::vector<int> shard_cases;
+  for (int i = shard; i < static_cast<int>(cases.size()); i += kNumShards) {
+    shard_cases.push_back(i);
+  }
+
+  const int num_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::vector<std::string>> errors(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; i < shard_cases.size(); i += num_threads) {
+        for (std::string& error :
+             Check(impl, shard_cases[i], cases[shard_cases[i]])) {
+          errors[t].push_back(std::move(error));
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const std::vector<std::string>& thread_errors : errors) {
+    for (const std::string& error : thread_errors) {
+      ADD_FAILURE() << impl.name << ": " << error;
+    }
+  }
+}
+
+std::string ParamName(
+    const ::testing::TestParamInfo<std::tuple<Implementation, int>>& info) {
+  return std::string(std::get<0>(info.param).name) + "_shard" +
+         std::to_string(std::get<1>(info.param));
+}
+
+INSTANTIATE_TEST_CASE_P(
+    AllImplementations, FarmhashGoldenTest,
+    ::testing::Combine(::testing::ValuesIn(kImplementations),
+                       ::testing::Range(0, kNumShards)),
+    ParamName);
 
-int main(int argc, char* argv[]) {
-  return RunTest();
+// Inputs over 2 GB must not overflow any byte counts. There are no golden
+// values for them, so the implementations are checked against each other.
+TEST(FarmhashLargeInputTest, ImplementationsAgree) {
+#if defined(__unix__) && defined(MAP_NORESERVE)
+  if (sizeof(size_t) < 8) return;
+  const size_t kSize = (size_t{1} << 31) + 100;
+  // Untouched pages of an anonymous mapping all share the zero page, so
+  // this costs little memory. Write a few bytes, including around the 2 GB
+  // mark, so that the input isn't all zeroes.
+  void* mapping = mmap(nullptr, kSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  ASSERT_NE(MAP_FAILED, mapping);
+  char* const data = static_cast<char*>(mapping);
+  for (size_t i : {size_t{0}, size_t{12345}, (size_t{1} << 31) - 1,
+                   size_t{1} << 31, kSize - 1}) {
+    data[i] = static_cast<char>(i * 131 + 7);
+  }
+  const uint64_t expected = DirectHash64(data, kSize);
+  EXPECT_EQ(expected, FrameworkHash64(data, kSize));
+  EXPECT_EQ(expected, N3980Hash64(data, kSize));
+  munmap(mapping, kSize);
+#endif
 }
+
+}  // namespace
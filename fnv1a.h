@@ -29,29 +29,13 @@ class fnv1a {
 
   fnv1a() {}
 
-  // Generic recursive case of hash_combine.
-  template <typename T, typename... Ts>
-  friend std::enable_if_t<!std_::is_uniquely_represented<T>::value,
-                          fnv1a>
-  hash_combine(fnv1a hash_code, const T& value, const Ts&... values) {
-    using std_::hash_value;
-    return hash_combine(hash_value(hash_code, value), values...);
-  }
-
-  // Base case of hash_combine: hash the bytes directly once we reach a
-  // uniquely-represented type.
-  template <typename T, typename... Ts>
-  friend std::enable_if_t<std_::is_uniquely_represented<T>::value,
-                          fnv1a>
-  hash_combine(fnv1a hash_code, const T& value, const Ts&... values) {
-    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&value);
-    return hash_combine(
-        hash_combine_range(hash_code, bytes, bytes + sizeof(value)), values...);
+  template <typename... Ts>
+  friend fnv1a hash_combine(fnv1a hash_code, const Ts&... values) {
+    (void)std_::detail::expand{
+        0, (hash_code = combine_one(hash_code, values), 0)...};
+    return hash_code;
   }
 
-  // Base case of variadic template recursion.
-  friend fnv1a hash_combine(fnv1a hash_code) { return hash_code; }
-
   // Generic iterative implementation of hash_combine_range.
   template <typename InputIterator>
   // Avoid ambiguity with the following overload
@@ -99,6 +83,22 @@ class fnv1a {
   explicit operator result_type() && noexcept { return state_; }
 
  private:
+  // Generic case of hash_combine for a single value.
+  template <typename T>
+  static std::enable_if_t<!std_::is_uniquely_represented<T>::value, fnv1a>
+  combine_one(fnv1a hash_code, const T& value) {
+    using std_::hash_value;
+    return hash_value(hash_code, value);
+  }
+
+  // Hash the bytes directly once we reach a uniquely-represented type.
+  template <typename T>
+  static std::enable_if_t<std_::is_uniquely_represented<T>::value, fnv1a>
+  combine_one(fnv1a hash_code, const T& value) {
+    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&value);
+    return hash_combine_range(hash_code, bytes, bytes + sizeof(value));
+  }
+
   static size_t mix(fnv1a hash_code, unsigned char c) {
     return (hash_code.state_ ^ c) * 1099511628211u;
   }
@@ -121,21 +121,11 @@ class type_invariant_fnv1a {
   type_invariant_fnv1a(type_invariant_fnv1a&&) = default;
   type_invariant_fnv1a& operator=(type_invariant_fnv1a&&) = default;
 
-  template <typename T, typename... Ts>
-  friend type_invariant_fnv1a hash_combine(
-      type_invariant_fnv1a hash_code, const T& value, const Ts&... values) {
-    using std_::hash_value;
-    return hash_combine(hash_value(std::move(hash_code), value), values...);
-  }
-
   template <typename... Ts>
   friend type_invariant_fnv1a hash_combine(
-      type_invariant_fnv1a hash_code, unsigned char c, const Ts&... values) {
-    return hash_combine(type_invariant_fnv1a(mix(std::move(hash_code), c)),
-                        values...);
-  }
-
-  friend type_invariant_fnv1a hash_combine(type_invariant_fnv1a hash_code) {
+      type_invariant_fnv1a hash_code, const Ts&... values) {
+    (void)std_::detail::expand{
+        0, (hash_code = combine_one(std::move(hash_code), values), 0)...};
     return hash_code;
   }
 
@@ -165,6 +155,18 @@ class type_invariant_fnv1a {
  private:
   type_invariant_fnv1a(result_type state) : state_(state) {}
 
+  template <typename T>
+  static type_invariant_fnv1a combine_one(
+      type_invariant_fnv1a hash_code, const T& value) {
+    using std_::hash_value;
+    return hash_value(std::move(hash_code), value);
+  }
+
+  static type_invariant_fnv1a combine_one(
+      type_invariant_fnv1a hash_code, unsigned char c) {
+    return type_invariant_fnv1a(mix(std::move(hash_code), c));
+  }
+
   static size_t mix(type_invariant_fnv1a hash_code, unsigned char c) {
     return (hash_code.state_ ^ c) * 1099511628211u;
   }
@@ -0,0 +1,454 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SMHasher-style statistical quality tests of the hash algorithms, applied
+// through the hash_value() path rather than to raw byte strings, since that
+// is how the algorithms see their input in practice. Each test prints the
+// statistic it measures, so that the quality of the algorithms can be
+// compared, but only algorithms that are expected to be of high quality
+// are required to meet a threshold.
+//
+// Bucket distribution is measured on the low bits of the hash, because
+// that is what power-of-two hash tables use.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "farmhash.h"
+#include "fnv1a.h"
+#include "multi_hash.h"
+#include "std.h"
+
+namespace {
+
+// HashHelper::Hash acts as an extension point, allowing us to customize
+// how a particular HashCode is constructed and invoked. The primary
+// template assumes HashCode is default-constructible.
+template <typename HashCode, typename T>
+struct HashHelper {
+  static uint64_t Hash(const T& t) {
+    using std_::hash_value;
+    return typename HashCode::result_type(hash_value(HashCode{}, t));
+  }
+};
+
+template <typename T>
+struct HashHelper<hashing::farmhash, T> {
+  static uint64_t Hash(const T& t) {
+    using std_::hash_value;
+    hashing::farmhash::state_type state;
+    return hashing::farmhash::result_type(
+        hash_value(hashing::farmhash{&state}, t));
+  }
+};
+
+// The lanes of a multi_hash differ only in their seeds, so we test one of
+// them, with a nonzero seed.
+template <typename T>
+struct HashHelper<hashing::multi_hash<4>, T> {
+  static uint64_t Hash(const T& t) {
+    using std_::hash_value;
+    hashing::multi_hash<4>::state_type state;
+    return hashing::multi_hash<4>::result_type(
+        hash_value(hashing::multi_hash<4>{&state, 1}, t))[3];
+  }
+};
+
+// Describes what is expected of each algorithm under test. 'strict'
+// algorithms must pass every test; the others are only measured.
+template <typename HashCode>
+struct QualityTraits;
+
+template <>
+struct QualityTraits<hashing::farmhash> {
+  static constexpr const char* name = "farmhash";
+  static constexpr bool strict = true;
+};
+
+template <>
+struct QualityTraits<hashing::multi_hash<4>> {
+  static constexpr const char* name = "multi_hash";
+  static constexpr bool strict = true;
+};
+
+template <>
+struct QualityTraits<hashing::fnv1a> {
+  static constexpr const char* name = "fnv1a";
+  static constexpr bool strict = false;
+};
+
+template <>
+struct QualityTraits<hashing::type_invariant_fnv1a> {
+  static constexpr const char* name = "type_invariant_fnv1a";
+  static constexpr bool strict = false;
+};
+
+constexpr int kHashBits = 64;
+
+// Number of random keys used by the avalanche and bit-independence tests.
+constexpr int kSamples = 2000;
+
+// Maximum acceptable deviation of an estimated probability or correlation
+// from its ideal value, for estimates based on kSamples samples. This is
+// about 6 standard deviations, which keeps false failures negligible
+// even across the tens of thousands of estimates in each test.
+const double kMaxDeviation = 3.0 / std::sqrt(kSamples);
+
+// Maximum acceptable chi-square z-score for bucket distributions.
+constexpr double kMaxZScore = 6.0;
+
+// Runs f(begin, end, thread) over disjoint slices of [0, n), one per
+// hardware thread, and waits for them to finish.
+template <typename F>
+void ParallelFor(size_t n, int num_threads, F f) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back(f, n * t / num_threads, n * (t + 1) / num_threads, t);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+int NumThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Stateless pseudo-random generator, so that keys depend only on their
+// index, and not on how the work is divided among threads.
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+template <typename Key>
+Key RandomKey(uint64_t index) {
+  unsigned char bytes[sizeof(Key)];
+  for (size_t i = 0; i < sizeof(Key); i += sizeof(uint64_t)) {
+    const uint64_t word = SplitMix64(index * sizeof(Key) + i);
+    memcpy(bytes + i, &word, std::min(sizeof(word), sizeof(Key) - i));
+  }
+  Key key;
+  memcpy(&key, bytes, sizeof(key));
+  return key;
+}
+
+template <typename Key>
+Key FlipBit(Key key, int bit) {
+  unsigned char bytes[sizeof(Key)];
+  memcpy(bytes, &key, sizeof(key));
+  bytes[bit / 8] ^= 1 << (bit % 8);
+  memcpy(&key, bytes, sizeof(key));
+  return key;
+}
+
+// Returns the number of pairs of equal values in 'hashes'.
+size_t CountCollisions(std::vector<uint64_t> hashes) {
+  std::sort(hashes.begin(), hashes.end());
+  size_t collisions = 0;
+  for (size_t i = 1; i < hashes.size(); ++i) {
+    if (hashes[i] == hashes[i - 1]) ++collisions;
+  }
+  return collisions;
+}
+
+// Returns the largest chi-square z-score of the distribution of 'hashes'
+// over power-of-two tables indexed by the low bits of the hash, for all
+// table sizes that leave at least 4 keys per bucket on average.
+double MaxBucketZScore(const std::vector<uint64_t>& hashes) {
+  double max_z = 0;
+  for (int bits = 1; (hashes.size() >> bits) >= 4; ++bits) {
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    std::vector<uint32_t> buckets(mask + 1);
+    for (uint64_t h : hashes) {
+      ++buckets[h & mask];
+    }
+    const double expected = static_cast<double>(hashes.size()) / (mask + 1);
+    double chi_square = 0;
+    for (uint32_t count : buckets) {
+      chi_square += (count - expected) * (count - expected) / expected;
+    }
+    // Convert to a standard normal score with the Wilson-Hilferty
+    // approximation, which unlike the plain normal approximation is also
+    // accurate for the small tables, where the low bits matter most.
+    const double degrees_of_freedom = mask;
+    const double variance = 2 / (9 * degrees_of_freedom);
+    const double z =
+        (std::cbrt(chi_square / degrees_of_freedom) - (1 - variance)) /
+        std::sqrt(variance);
+    max_z = std::max(max_z, std::abs(z));
+  }
+  return max_z;
+}
+
+template <typename HashCode>
+class HashQualityTest : public ::testing::Test {
+ public:
+  using Traits = QualityTraits<HashCode>;
+
+  template <typename T>
+  static uint64_t Hash(const T& t) {
+    return HashHelper<HashCode, T>::Hash(t);
+  }
+
+  // Hashes key(i) for each i in [0, n), in parallel.
+  template <typename KeyFunction>
+  static std::vector<uint64_t> HashAll(size_t n, KeyFunction key) {
+    std::vector<uint64_t> hashes(n);
+    ParallelFor(n, NumThreads(), [&](size_t begin, size_t end, int) {
+      for (size_t i = begin; i < end; ++i) {
+        hashes[i] = Hash(key(i));
+      }
+    });
+    return hashes;
+  }
+
+  void Report(const std::string& test, double value) {
+    std::cout << "[ quality  ] " << Traits::name << " " << test << ": "
+              << value << std::endl;
+    ::testing::Test::RecordProperty(test, std::to_string(value));
+  }
+
+  // Checks the collision count and bucket distribution of a key set.
+  void CheckKeySet(const std::string& name,
+                   const std::vector<uint64_t>& hashes) {
+    const size_t collisions = CountCollisions(hashes);
+    const double z = MaxBucketZScore(hashes);
+    Report(name + " collisions", collisions);
+    Report(name + " max bucket z-score", z);
+    if (Traits::strict) {
+      EXPECT_EQ(0, collisions) << name;
+      EXPECT_LT(z, kMaxZScore) << name;
+    }
+  }
+
+  template <typename Key>
+  void CheckAvalanche(const std::string& key_name);
+
+  template <typename Key>
+  void CheckBitIndependence(const std::string& key_name);
+};
+
+TYPED_TEST_CASE_P(HashQualityTest);
+
+// Strict avalanche criterion: flipping any input bit should flip each
+// output bit with probability 1/2.
+template <typename HashCode>
+template <typename Key>
+void HashQualityTest<HashCode>::CheckAvalanche(const std::string& key_name) {
+  constexpr int kKeyBits = sizeof(Key) * 8;
+  const int num_threads = NumThreads();
+  std::vector<std::vector<uint32_t>> flips(
+      num_threads, std::vector<uint32_t>(kKeyBits * kHashBits));
+  ParallelFor(kSamples, num_threads, [&](size_t begin, size_t end, int t) {
+    std::vector<uint32_t>& counts = flips[t];
+    for (size_t s = begin; s < end; ++s) {
+      const Key key = RandomKey<Key>(s);
+      const uint64_t hash = Hash(key);
+      for (int i = 0; i < kKeyBits; ++i) {
+        const uint64_t diff = hash ^ Hash(FlipBit(key, i));
+        for (int j = 0; j < kHashBits; ++j) {
+          counts[i * kHashBits + j] += (diff >> j) & 1;
+        }
+      }
+    }
+  });
+
+  double max_bias = 0;
+  for (int cell = 0; cell < kKeyBits * kHashBits; ++cell) {
+    uint32_t total = 0;
+    for (int t = 0; t < num_threads; ++t) {
+      total += flips[t][cell];
+    }
+    max_bias = std::max(max_bias, std::abs(double(total) / kSamples - 0.5));
+  }
+  Report("avalanche<" + key_name + "> max bias", max_bias);
+  if (Traits::strict) {
+    EXPECT_LT(max_bias, kMaxDeviation) << key_name;
+  }
+}
+
+// Bit independence criterion: when an input bit is flipped, the flips of
+// any two output bits should be uncorrelated.
+template <typename HashCode>
+template <typename Key>
+void HashQualityTest<HashCode>::CheckBitIndependence(
+    const std::string& key_name) {
+  constexpr int kKeyBits = sizeof(Key) * 8;
+  constexpr int kCells = kHashBits * kHashBits;
+  const int num_threads = NumThreads();
+  // For input bit i, cell (j, j) counts flips of output bit j, and cell
+  // (j, k) for j < k counts joint flips of output bits j and k.
+  std::vector<std::vector<uint32_t>> flips(
+      num_threads, std::vector<uint32_t>(kKeyBits * kCells));
+  ParallelFor(kSamples, num_threads, [&](size_t begin, size_t end, int t) {
+    std::vector<uint32_t>& counts = flips[t];
+    for (size_t s = begin; s < end; ++s) {
+      const Key key = RandomKey<Key>(s);
+      const uint64_t hash = Hash(key);
+      for (int i = 0; i < kKeyBits; ++i) {
+        uint32_t* cells = &counts[i * kCells];
+        const uint64_t diff = hash ^ Hash(FlipBit(key, i));
+        for (uint64_t rest = diff; rest != 0; rest &= rest - 1) {
+          const int j = __builtin_ctzll(rest);
+          for (uint64_t others = rest; others != 0; others &= others - 1) {
+            ++cells[j * kHashBits + __builtin_ctzll(others)];
+          }
+        }
+      }
+    }
+  });
+
+  std::vector<uint32_t> totals(kKeyBits * kCells);
+  for (int t = 0; t < num_threads; ++t) {
+    for (size_t cell = 0; cell < totals.size(); ++cell) {
+      totals[cell] += flips[t][cell];
+    }
+  }
+  double max_correlation = 0;
+  for (int i = 0; i < kKeyBits; ++i) {
+    const uint32_t* cells = &totals[i * kCells];
+    for (int j = 0; j < kHashBits; ++j) {
+      const double pj = double(cells[j * kHashBits + j]) / kSamples;
+      for (int k = j + 1; k < kHashBits; ++k) {
+        const double pk = double(cells[k * kHashBits + k]) / kSamples;
+        const double pjk = double(cells[j * kHashBits + k]) / kSamples;
+        const double variance = pj * (1 - pj) * pk * (1 - pk);
+        // A bit that never (or always) flips is maximally dependent.
+        const double correlation =
+            variance > 0 ? (pjk - pj * pk) / std::sqrt(variance) : 1.0;
+        max_correlation = std::max(max_correlation, std::abs(correlation));
+      }
+    }
+  }
+  Report("bit independence<" + key_name + "> max correlation",
+         max_correlation);
+  if (Traits::strict) {
+    EXPECT_LT(max_correlation, 2 * kMaxDeviation) << key_name;
+  }
+}
+
+TYPED_TEST_P(HashQualityTest, Avalanche) {
+  this->template CheckAvalanche<uint32_t>("uint32_t");
+  this->template CheckAvalanche<uint64_t>("uint64_t");
+  this->template CheckAvalanche<std::array<uint64_t, 2>>("array<uint64_t, 2>");
+  this->template CheckAvalanche<std::array<uint64_t, 4>>("array<uint64_t, 4>");
+  this->template CheckAvalanche<std::array<uint64_t, 8>>("array<uint64_t, 8>");
+}
+
+TYPED_TEST_P(HashQualityTest, BitIndependence) {
+  this->template CheckBitIndependence<uint32_t>("uint32_t");
+  this->template CheckBitIndependence<uint64_t>("uint64_t");
+}
+
+// Keys with very few bits set, which stress how well an algorithm mixes
+// mostly-zero input.
+TYPED_TEST_P(HashQualityTest, SparseKeys) {
+  // Every uint64_t with at most 3 bits set.
+  std::vector<uint64_t> ints = {0};
+  for (int i = 0; i < 64; ++i) {
+    ints.push_back(uint64_t{1} << i);
+    for (int j = i + 1; j < 64; ++j) {
+      ints.push_back((uint64_t{1} << i) | (uint64_t{1} << j));
+      for (int k = j + 1; k < 64; ++k) {
+        ints.push_back((uint64_t{1} << i) | (uint64_t{1} << j) |
+                       (uint64_t{1} << k));
+      }
+    }
+  }
+  this->CheckKeySet("sparse uint64_t",
+                    this->HashAll(ints.size(), [&](size_t i) {
+                      return ints[i];
+                    }));
+
+  // Every 32-byte string with at most 2 bits set.
+  std::vector<std::pair<int, int>> bits = {{-1, -1}};
+  for (int i = 0; i < 256; ++i) {
+    bits.emplace_back(i, -1);
+    for (int j = i + 1; j < 256; ++j) {
+      bits.emplace_back(i, j);
+    }
+  }
+  this->CheckKeySet(
+      "sparse 32-byte string", this->HashAll(bits.size(), [&](size_t i) {
+        std::string key(32, '\0');
+        for (int bit : {bits[i].first, bits[i].second}) {
+          if (bit >= 0) key[bit / 8] ^= 1 << (bit % 8);
+        }
+        return key;
+      }));
+}
+
+// Keys consisting of a short random byte sequence repeated several times,
+// which stress algorithms whose internal state can fall into a cycle.
+TYPED_TEST_P(HashQualityTest, CyclicKeys) {
+  constexpr int kNumKeys = 100000;
+  constexpr int kRepetitions = 8;
+  for (int cycle_length : {4, 5, 8, 12, 16}) {
+    this->CheckKeySet(
+        "cyclic " + std::to_string(cycle_length) + "x" +
+            std::to_string(kRepetitions) + " string",
+        this->HashAll(kNumKeys, [&](size_t i) {
+          // The cycle starts with the key index, so that all keys are
+          // distinct, and continues with random bytes.
+          auto cycle = RandomKey<std::array<uint64_t, 2>>(i);
+          const uint32_t index = i;
+          memcpy(&cycle, &index, sizeof(index));
+          std::string key;
+          for (int r = 0; r < kRepetitions; ++r) {
+            key.append(reinterpret_cast<const char*>(&cycle), cycle_length);
+          }
+          return key;
+        }));
+  }
+}
+
+// Sequential integers are the most common hash table keys, and the ones
+// most likely to expose poor low bits.
+TYPED_TEST_P(HashQualityTest, SequentialKeys) {
+  constexpr int kNumKeys = 1 << 18;
+  this->CheckKeySet("sequential uint32_t",
+                    this->HashAll(kNumKeys, [](size_t i) {
+                      return static_cast<uint32_t>(i);
+                    }));
+  this->CheckKeySet("shifted sequential uint64_t",
+                    this->HashAll(kNumKeys, [](size_t i) {
+                      return static_cast<uint64_t>(i) << 32;
+                    }));
+}
+
+REGISTER_TYPED_TEST_CASE_P(HashQualityTest,
+                           Avalanche,
+                           BitIndependence,
+                           SparseKeys,
+                           CyclicKeys,
+                           SequentialKeys);
+
+using HashCodeTypes = ::testing::Types<
+  hashing::farmhash, hashing::multi_hash<4>, hashing::fnv1a,
+  hashing::type_invariant_fnv1a>;
+INSTANTIATE_TYPED_TEST_CASE_P(My, HashQualityTest, HashCodeTypes);
+
+}  // namespace
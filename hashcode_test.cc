@@ -18,6 +18,7 @@
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -54,6 +55,19 @@ struct HashHelper<hashing::farmhash, T> {
   }
 };
 
+template <typename T>
+struct HashHelper<hashing::profiling<hashing::farmhash>, T> {
+  static hashing::farmhash::result_type Hash(const T& t) {
+    using std_::hash_value;
+    hashing::farmhash::state_type state;
+    hashing::hash_profile profile;
+    return hashing::farmhash::result_type(hash_value(
+        hashing::profiling<hashing::farmhash>{hashing::farmhash{&state},
+                                              &profile},
+        t));
+  }
+};
+
 template <typename HashCode>
 class HashCodeTest : public ::testing::Test {
  public:
@@ -222,15 +236,71 @@ TYPED_TEST_P(HashCodeTest, HashPimplType) {
   EXPECT_EQ(this->Hash(EquivalentToPimpl{}), this->Hash(Pimpl{}));
 }
 
+TYPED_TEST_P(HashCodeTest, HashCachedPimplType) {
+  // A CachedPimpl hashes as the std_::hash_code digest of its contents.
+  EXPECT_EQ(this->Hash(std_::hash<EquivalentToPimpl>{}(EquivalentToPimpl{})),
+            this->Hash(CachedPimpl{}));
+}
+
 REGISTER_TYPED_TEST_CASE_P(HashCodeTest,
                            NoOpsAreEquivalent,
                            HashCombineIntegralType,
                            HashNonUniquelyRepresentedType,
-                           HashPimplType);
+                           HashPimplType,
+                           HashCachedPimplType);
 
 using HashCodeTypes = ::testing::Types<
   hashing::farmhash, hashing::fnv1a, hashing::type_invariant_fnv1a,
-  hashing::identity>;
+  hashing::identity, hashing::profiling<hashing::farmhash>>;
 INSTANTIATE_TYPED_TEST_CASE_P(My, HashCodeTest, HashCodeTypes);
 
+TEST(ProfilingTest, CountsBulkAndPerElementCalls) {
+  const std::string s = "abc";
+  // vector iterators are not known to be contiguous, so the ints are
+  // hashed one at a time.
+  const std::vector<int> v = {1, 2, 3};
+
+  hashing::hash_profile profile;
+  hashing::farmhash::state_type profiled_state;
+  const size_t profiled_hash = size_t(hash_combine(
+      hashing::profiling<hashing::farmhash>{
+          hashing::farmhash{&profiled_state}, &profile},
+      s, v));
+
+  hashing::farmhash::state_type state;
+  EXPECT_EQ(size_t(hash_combine(hashing::farmhash{&state}, s, v)),
+            profiled_hash);
+
+  EXPECT_EQ(6, profile.calls);
+  EXPECT_EQ(3, profile.per_element_calls);
+  EXPECT_EQ(3, profile.bulk_calls());
+  EXPECT_EQ(3 + sizeof(size_t) + 3 * sizeof(int) + sizeof(size_t),
+            profile.bytes);
+  EXPECT_EQ(1, profile.size_histogram[2]);  // [2, 4): the characters
+  EXPECT_EQ(3, profile.size_histogram[3]);  // [4, 8): the ints
+  EXPECT_EQ(2, profile.size_histogram[4]);  // [8, 16): the sizes
+
+  std::ostringstream report;
+  profile.report(report);
+  EXPECT_NE(std::string::npos, report.str().find("3 per-element"));
+}
+
+TEST(ProfilingTest, CountsNestedBytesAsBulk) {
+  // The strings are visited one at a time, but each one's characters are
+  // hashed in one bulk call; only their sizes are per-element.
+  const std::vector<std::string> v = {"ab", "cd", "ef"};
+
+  hashing::hash_profile profile;
+  hashing::farmhash::state_type state;
+  hash_combine(hashing::profiling<hashing::farmhash>{
+                   hashing::farmhash{&state}, &profile},
+               v);
+
+  EXPECT_EQ(7, profile.calls);
+  EXPECT_EQ(3, profile.per_element_calls);
+  EXPECT_EQ(4, profile.bulk_calls());
+  EXPECT_EQ(3, profile.size_histogram[2]);  // [2, 4): the characters
+  EXPECT_EQ(4, profile.size_histogram[4]);  // [8, 16): the sizes
+}
+
 }  // namespace
@@ -0,0 +1,239 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Thread-safe string interning. intern_pool::intern() returns an
+// interned_string handle, and all handles for equal strings from the same
+// pool refer to the same storage, so they can be compared and hashed as
+// pointers. This is also a demonstration of a type whose hash_value()
+// depends on the hash algorithm: ordinary algorithms hash the pointer, but
+// type-invariant ones hash the contents, as std::string does.
+
+#ifndef HASHING_DEMO_INTERN_POOL_H
+#define HASHING_DEMO_INTERN_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "farmhash-core.h"
+#include "fnv1a.h"
+#include "std_impl.h"
+
+namespace hashing {
+
+namespace detail {
+
+// An interned string, allocated from its pool's arena: this header,
+// followed by the 'size' bytes of the string and a terminating NUL.
+struct interned_entry {
+  // FarmHash of the bytes, which the pool uses to look up and rehash
+  // entries without reading the bytes again.
+  uint64_t hash;
+  size_t size;
+
+  const char* data() const {
+    return reinterpret_cast<const char*>(this + 1);
+  }
+};
+
+}  // namespace detail
+
+// Handle to a string in an intern_pool. Handles are cheap to copy, and
+// remain valid for the lifetime of the pool. Handles from different pools
+// must not be compared.
+class interned_string {
+  friend class intern_pool;
+
+  const detail::interned_entry* entry_;
+
+  explicit interned_string(const detail::interned_entry* entry)
+      : entry_(entry) {}
+
+ public:
+  const char* data() const { return entry_->data(); }
+  const char* c_str() const { return entry_->data(); }
+  size_t size() const { return entry_->size; }
+  const char* begin() const { return data(); }
+  const char* end() const { return data() + size(); }
+  std::string str() const { return std::string(data(), size()); }
+
+  // Equal strings from the same pool share an entry, so comparison is a
+  // pointer comparison.
+  friend bool operator==(interned_string lhs, interned_string rhs) {
+    return lhs.entry_ == rhs.entry_;
+  }
+  friend bool operator!=(interned_string lhs, interned_string rhs) {
+    return lhs.entry_ != rhs.entry_;
+  }
+
+  // For the same reason, ordinary hashing can hash the pointer, which is
+  // much more efficient than hashing the whole string.
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, interned_string s) {
+    return hash_combine(std::move(hash_code), s.entry_);
+  }
+
+  // However, if we're being hashed by a type-invariant hash algorithm,
+  // we're presumably being compared to other types of strings, so we
+  // need to hash the full string value, exactly as std::string does. The
+  // bytes are hashed in place, without copying them into a std::string.
+  friend type_invariant_fnv1a hash_value(
+      type_invariant_fnv1a hash_code, interned_string s) {
+    return std_::detail::hash_sized_container(std::move(hash_code), s);
+  }
+};
+
+// Concurrent set of interned strings. Lookups of strings that are already
+// interned take no locks. Each shard of the pool is an open-addressing
+// table of pointers to entries, keyed by FarmHash; a miss takes the
+// shard's lock, and copies the string into the shard's arena.
+class intern_pool {
+  using entry = detail::interned_entry;
+
+  static constexpr int kShardBits = 4;
+  static constexpr size_t kInitialCapacity = 16;
+
+  struct table {
+    // capacity - 1, where the capacity is a power of two.
+    size_t mask;
+    std::unique_ptr<std::atomic<const entry*>[]> slots;
+
+    explicit table(size_t capacity)
+        : mask(capacity - 1),
+          slots(new std::atomic<const entry*>[capacity]()) {}
+  };
+
+  struct shard {
+    std::atomic<const table*> current;
+    std::mutex mutex;
+    // The fields below are guarded by 'mutex'.
+    size_t size = 0;
+    arena strings;
+    // Every table this shard has used. Readers may still be probing a
+    // table after it has been replaced, so tables are only freed with the
+    // pool.
+    std::vector<std::unique_ptr<table>> tables;
+
+    shard() {
+      tables.emplace_back(new table(kInitialCapacity));
+      current.store(tables.back().get(), std::memory_order_relaxed);
+    }
+  };
+
+  shard shards_[1 << kShardBits];
+
+ public:
+  intern_pool() = default;
+
+  intern_pool(const intern_pool&) = delete;
+  intern_pool& operator=(const intern_pool&) = delete;
+
+  interned_string intern(const char* data, size_t size) {
+    const uint64_t hash = farmhash_core::Hash64(
+        reinterpret_cast<const unsigned char*>(data), size);
+    // The high bits choose the shard, and the low bits the slot.
+    shard& s = shards_[hash >> (64 - kShardBits)];
+    const entry* e =
+        find(s.current.load(std::memory_order_acquire), hash, data, size);
+    if (e == nullptr) {
+      e = insert(&s, hash, data, size);
+    }
+    return interned_string(e);
+  }
+
+  interned_string intern(const std::string& s) {
+    return intern(s.data(), s.size());
+  }
+
+  interned_string intern(const char* s) { return intern(s, strlen(s)); }
+
+ private:
+  static const entry* find(const table* t, uint64_t hash, const char* data,
+                           size_t size) {
+    for (size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+      const entry* e = t->slots[i].load(std::memory_order_acquire);
+      if (e == nullptr) {
+        return nullptr;
+      }
+      if (e->hash == hash && e->size == size &&
+          memcmp(e->data(), data, size) == 0) {
+        return e;
+      }
+    }
+  }
+
+  // Stores 'e' in the first free slot for its hash.
+  static void store(table* t, const entry* e) {
+    size_t i = e->hash & t->mask;
+    while (t->slots[i].load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & t->mask;
+    }
+    t->slots[i].store(e, std::memory_order_release);
+  }
+
+  static const entry* insert(shard* s, uint64_t hash, const char* data,
+                             size_t size) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    table* t = s->tables.back().get();
+    // Another thread may have inserted the string, or replaced the table,
+    // since the caller's lookup.
+    if (const entry* e = find(t, hash, data, size)) {
+      return e;
+    }
+
+    // Keep the load factor at most 1/2, so probe sequences stay short.
+    if (2 * (s->size + 1) > t->mask + 1) {
+      std::unique_ptr<table> bigger(new table(2 * (t->mask + 1)));
+      for (size_t i = 0; i <= t->mask; ++i) {
+        if (const entry* e = t->slots[i].load(std::memory_order_relaxed)) {
+          store(bigger.get(), e);
+        }
+      }
+      t = bigger.get();
+      s->tables.push_back(std::move(bigger));
+      s->current.store(t, std::memory_order_release);
+    }
+
+    entry* e = static_cast<entry*>(
+        s->strings.allocate(sizeof(entry) + size + 1, alignof(entry)));
+    e->hash = hash;
+    e->size = size;
+    char* bytes = reinterpret_cast<char*>(e + 1);
+    if (size > 0) {
+      memcpy(bytes, data, size);
+    }
+    bytes[size] = '\0';
+    store(t, e);
+    ++s->size;
+    return e;
+  }
+};
+
+}  // namespace hashing
+
+namespace std_ {
+
+template <>
+struct is_uniquely_represented<hashing::interned_string> : public true_type {};
+
+}  // namespace std_
+
+#endif  // HASHING_DEMO_INTERN_POOL_H
@@ -0,0 +1,101 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "intern_pool.h"
+#include "std.h"
+
+namespace {
+
+TEST(InternPoolTest, EqualStringsShareAnEntry) {
+  hashing::intern_pool pool;
+  const hashing::interned_string a = pool.intern("abc");
+  EXPECT_EQ(a, pool.intern(std::string("abc")));
+  EXPECT_EQ(a, pool.intern("abcd", 3));
+  EXPECT_EQ(a.data(), pool.intern("abc").data());
+  EXPECT_NE(a, pool.intern("abd"));
+  EXPECT_NE(a, pool.intern("ab"));
+}
+
+TEST(InternPoolTest, PreservesContents) {
+  hashing::intern_pool pool;
+  const std::string with_nul("a\0b", 3);
+  for (const std::string& s :
+       {std::string(), std::string("x"), with_nul, std::string(1000, 'y')}) {
+    const hashing::interned_string interned = pool.intern(s);
+    EXPECT_EQ(s, interned.str());
+    EXPECT_EQ(s.size(), interned.size());
+    EXPECT_EQ('\0', interned.c_str()[s.size()]);
+  }
+  EXPECT_NE(pool.intern(""), pool.intern(with_nul));
+}
+
+TEST(InternPoolTest, SurvivesGrowth) {
+  hashing::intern_pool pool;
+  std::vector<hashing::interned_string> interned;
+  for (int i = 0; i < 100000; ++i) {
+    interned.push_back(pool.intern(std::to_string(i)));
+  }
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_EQ(interned[i], pool.intern(std::to_string(i)));
+    ASSERT_EQ(std::to_string(i), interned[i].str());
+  }
+}
+
+TEST(InternPoolTest, ConcurrentInterning) {
+  hashing::intern_pool pool;
+  const int kThreads = 4;
+  const int kStrings = 20000;
+  std::vector<std::vector<hashing::interned_string>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&pool, &results, t] {
+      // Each thread interns the same strings, in a different order.
+      for (int i = 0; i < kStrings; ++i) {
+        const int n = (i * (2 * t + 1)) % kStrings;
+        results[t].push_back(pool.intern("s" + std::to_string(n)));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kStrings; ++i) {
+      const int n = (i * (2 * t + 1)) % kStrings;
+      ASSERT_EQ(pool.intern("s" + std::to_string(n)), results[t][i]);
+    }
+  }
+}
+
+TEST(InternPoolTest, HashesThePointer) {
+  hashing::intern_pool pool;
+  const hashing::interned_string s = pool.intern("abc");
+  const char* data = s.data();
+  EXPECT_EQ(std_::hash<hashing::interned_string>()(s),
+            std_::hash<hashing::interned_string>()(pool.intern("abc")));
+  EXPECT_NE(std_::hash<hashing::interned_string>()(s),
+            std_::hash<hashing::interned_string>()(pool.intern("abd")));
+  // The hash doesn't depend on the contents, but only on the entry.
+  EXPECT_NE(std_::hash<hashing::interned_string>()(s),
+            std_::hash<std::string>()(std::string(data)));
+}
+
+}  // namespace
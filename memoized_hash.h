@@ -0,0 +1,72 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HASHING_DEMO_MEMOIZED_HASH_H
+#define HASHING_DEMO_MEMOIZED_HASH_H
+
+#include <cstddef>
+#include <utility>
+
+#include "std.h"
+
+namespace hashing {
+
+// Opt-in wrapper for large immutable values that are hashed repeatedly,
+// e.g. as keys of several maps. The std_::hash_code digest of the wrapped
+// value is computed once, at construction, and stored alongside it.
+// hash_value() then mixes in only that digest, so hashing a memoized_hash
+// costs the same regardless of how large the value is.
+//
+// The price is that the result is a hash of a hash: the outer HashCode
+// never sees the value's own hash representation. This means that
+// hash_value(code, memoized_hash<T>(t)) is not equal to hash_value(code, t),
+// the quality of the outer hash is capped by the 64 bits of the inner
+// digest, and type-invariant algorithms such as type_invariant_fnv1a lose
+// their type-invariance. The inner algorithm is always std_::hash_code,
+// whatever HashCode the outer hash uses.
+template <typename T>
+class memoized_hash {
+  const T value_;
+  const size_t hash_;
+
+  static size_t compute_hash(const T& value) {
+    std_::hash_code::state_type state;
+    using std_::hash_value;
+    return std_::hash_code::result_type(
+        hash_value(std_::hash_code{&state}, value));
+  }
+
+ public:
+  template <typename... Args>
+  explicit memoized_hash(Args&&... args)
+      : value_(std::forward<Args>(args)...), hash_(compute_hash(value_)) {}
+
+  // Non-copyable, because T may be large; share it by pointer instead.
+  memoized_hash(const memoized_hash&) = delete;
+  memoized_hash& operator=(const memoized_hash&) = delete;
+
+  const T& value() const { return value_; }
+
+  // Returns the cached std_::hash_code digest of value().
+  size_t hash() const { return hash_; }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const memoized_hash& m) {
+    return hash_combine(std::move(hash_code), m.hash_);
+  }
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_MEMOIZED_HASH_H
@@ -0,0 +1,300 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// HashCode that computes K independently seeded 64-bit hashes of its input
+// in a single pass, for data structures that need several hashes per key,
+// such as Bloom filters, Count-Min sketches, MinHash and cuckoo tables.
+// For example:
+//
+//   hashing::multi_hash<4>::state_type state;
+//   const std::array<uint64_t, 4> hashes =
+//       hashing::multi_hash<4>::result_type(
+//           hash_value(hashing::multi_hash<4>{&state}, key));
+//
+// The input is read once, 64 bytes at a time, and each stripe is mixed into
+// all K lanes. Each lane combines the stripe with its own seeded keys
+// before mixing it in, so that a pair of inputs that collides in one lane,
+// or for one seed, is no more likely to collide in another. The lanes are
+// independent of each other, so the processor can mix them in parallel.
+//
+// This saves the per-pass setup and finalization of K separate hashes, but
+// not the per-byte work: each lane still costs four 64x64->128-bit
+// multiplies and one 64-bit multiply per stripe, about as much as a
+// farmhash pass. In the "Multiple hashes per key" benchmarks on x86-64, it
+// is several times faster than K separate farmhash passes for keys of up
+// to a few hundred bytes, but only 20-30% faster at 64 KB for K of 2 or 4,
+// and no faster at 64 KB for K = 8, where the lanes no longer fit in
+// registers.
+
+#ifndef HASHING_DEMO_MULTI_HASH_H
+#define HASHING_DEMO_MULTI_HASH_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "std_impl.h"
+
+namespace hashing {
+
+template <size_t K>
+class multi_hash {
+  static_assert(K > 0, "multi_hash requires at least one lane");
+
+ public:
+  class state_type;
+  using result_type = std::array<uint64_t, K>;
+
+  // Move only
+  multi_hash(const multi_hash&) = delete;
+  multi_hash& operator=(const multi_hash&) = delete;
+  multi_hash(multi_hash&&) = default;
+  multi_hash& operator=(multi_hash&&) = default;
+
+  // Constructs a multi_hash pointing to s, as for farmhash. Each seed gives
+  // a different family of K hash functions.
+  explicit multi_hash(state_type* s, uint64_t seed = 0);
+
+  template <typename... Ts>
+  friend multi_hash hash_combine(multi_hash hash_code, const Ts&... values) {
+    return std_::simple_hash_combine(std::move(hash_code), values...);
+  }
+
+  template <typename InputIterator>
+  friend multi_hash hash_combine_range(
+      multi_hash hash_code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(std::move(hash_code), begin, end);
+  }
+
+  // Fundamental base case for hash recursion: mixes the given range of
+  // bytes into every lane.
+  friend multi_hash hash_combine_range(
+      multi_hash hash_code, const unsigned char* begin,
+      const unsigned char* end) {
+    hash_code.append(begin, end);
+    return hash_code;
+  }
+
+  explicit operator result_type() &&;
+
+ private:
+  static constexpr uint64_t kMul = 0xc6a4a7935bd1e995ULL;
+
+  // Each lane has one key per 8 bytes of a 64-byte stripe.
+  static constexpr size_t kKeysPerLane = 8;
+  static constexpr size_t kKeys = kKeysPerLane * K;
+
+  static uint64_t Fetch64(const unsigned char* p) {
+    uint64_t result;
+    memcpy(&result, p, sizeof(result));
+    return result;
+  }
+
+  // Finalizer from MurmurHash3, which makes every output bit depend on
+  // every input bit.
+  static uint64_t FinalMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Returns the xor of the high and low halves of the 128-bit product of
+  // a and b.
+  static uint64_t MulFold64(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^
+           static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo;
+    const uint64_t hi_lo = a_hi * b_lo;
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + a_lo * b_hi;
+    const uint64_t high = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+    const uint64_t low = (cross << 32) | (lo_lo & 0xffffffff);
+    return high ^ low;
+#endif
+  }
+
+  // Mixes up to one 64-byte stripe of input, the 16-byte blocks Bs at 'p',
+  // into one lane. Each half of each block is combined with its own
+  // key from 'keys', and the wide products of the halves are folded
+  // together, in the manner of wyhash and UMAC; the lane's own multiply,
+  // once per stripe, makes the result depend on the order of the stripes.
+  // The products depend on the keys, so a difference between two inputs
+  // propagates differently in each lane and for each seed; an unkeyed
+  // scramble shared by every lane would let some differences cancel in all
+  // of them at once. (A half equal to its key zeroes the product, so the
+  // lane then ignores the other half of that block; for input that does
+  // not depend on the keys, that happens with probability 2^-64.)
+  template <size_t... Bs>
+  static uint64_t mix_lane(uint64_t lane, const uint64_t* keys,
+                           const unsigned char* p, std::index_sequence<Bs...>) {
+    uint64_t products = 0;
+    (void)std_::detail::expand{
+        0, (products ^= MulFold64(Fetch64(p + 16 * Bs) ^ keys[2 * Bs],
+                                  Fetch64(p + 16 * Bs + 8) ^ keys[2 * Bs + 1]),
+            0)...};
+    return (lane ^ products) * kMul;
+  }
+
+  // Mixes the first N blocks of the stripe at 'p' into each lane. The lanes
+  // and blocks are unrolled at compile time, so that the lanes can be kept
+  // in registers and mixed in parallel.
+  template <size_t N>
+  static void mix(uint64_t (&lanes)[K], const uint64_t (&keys)[kKeys],
+                  const unsigned char* p) {
+    mix_lanes(lanes, keys, p, std::make_index_sequence<N>(),
+              std::make_index_sequence<K>());
+  }
+
+  template <size_t... Bs, size_t... Is>
+  static void mix_lanes(uint64_t (&lanes)[K], const uint64_t (&keys)[kKeys],
+                        const unsigned char* p, std::index_sequence<Bs...> bs,
+                        std::index_sequence<Is...>) {
+    (void)std_::detail::expand{
+        0, (lanes[Is] = mix_lane(lanes[Is], keys + kKeysPerLane * Is, p, bs),
+            0)...};
+  }
+
+  // Each lane starts from, and is keyed by, different functions of the
+  // seed. With the default seed, these fold to constants.
+  template <size_t... Is>
+  static void seed_lanes(uint64_t (&lanes)[K], uint64_t seed,
+                         std::index_sequence<Is...>) {
+    (void)std_::detail::expand{
+        0, (lanes[Is] = FinalMix(seed + ((kKeysPerLane + 1) * Is + 1) *
+                                            0x9e3779b97f4a7c15ULL),
+            0)...};
+  }
+
+  template <size_t... Is>
+  static void seed_keys(uint64_t (&keys)[kKeys], uint64_t seed,
+                        std::index_sequence<Is...>) {
+    (void)std_::detail::expand{
+        0, (keys[Is] = FinalMix(seed + (Is + Is / kKeysPerLane + 2) *
+                                           0x9e3779b97f4a7c15ULL),
+            0)...};
+  }
+
+  template <size_t... Is>
+  static result_type finish_lanes(const uint64_t (&lanes)[K], size_t len,
+                                  std::index_sequence<Is...>) {
+    return result_type{{FinalMix(lanes[Is] ^ len)...}};
+  }
+
+  // Mixes the 'n' whole stripes at 'p' into the lanes.
+  static void mix_stripes(uint64_t (&lanes)[K], const uint64_t (&keys)[kKeys],
+                          const unsigned char* p, size_t n) {
+    // Work on a local copy of the lanes, so that they can stay in
+    // registers.
+    uint64_t local[K];
+    memcpy(local, lanes, sizeof(local));
+    for (size_t i = 0; i < n; ++i) {
+      mix<4>(local, keys, p + 64 * i);
+    }
+    memcpy(lanes, local, sizeof(local));
+  }
+
+  void append(const unsigned char* begin, const unsigned char* end) {
+    const size_t buffered = len_ % 64;
+    len_ += end - begin;
+    if (static_cast<size_t>(end - begin) < 64 - buffered) {
+      // The input will not fill the buffer, so we just copy it.
+      memcpy(state_->buffer_ + buffered, begin, end - begin);
+      return;
+    }
+    append_blocks(buffered, begin, end);
+  }
+
+  void append_blocks(size_t buffered, const unsigned char* begin,
+                     const unsigned char* end);
+
+  state_type* state_;
+
+  // Number of bytes of input so far. As in farmhash, this is kept here
+  // rather than in state_type so that the optimizer can track it. The
+  // last len_ % 64 bytes are buffered in state_->buffer_.
+  size_t len_ = 0;
+};
+
+template <size_t K>
+class multi_hash<K>::state_type {
+ public:
+  // Non-movable
+  state_type(const state_type&) = delete;
+  state_type& operator=(const state_type&) = delete;
+  state_type(state_type&&) = delete;
+  state_type& operator=(state_type&&) = delete;
+
+  // The members are initialized by the multi_hash constructor.
+  state_type() {}
+
+ private:
+  friend class multi_hash;
+
+  uint64_t lanes_[K];
+  uint64_t keys_[kKeys];
+  unsigned char buffer_[64];
+};
+
+template <size_t K>
+multi_hash<K>::multi_hash(state_type* s, uint64_t seed) : state_(s) {
+  seed_lanes(state_->lanes_, seed, std::make_index_sequence<K>());
+  seed_keys(state_->keys_, seed, std::make_index_sequence<kKeys>());
+}
+
+template <size_t K>
+void multi_hash<K>::append_blocks(size_t buffered, const unsigned char* begin,
+                                  const unsigned char* end) {
+  // Fill the buffer and mix it, then mix whole stripes directly from the
+  // input, and buffer the rest.
+  memcpy(state_->buffer_ + buffered, begin, 64 - buffered);
+  begin += 64 - buffered;
+  mix_stripes(state_->lanes_, state_->keys_, state_->buffer_, 1);
+  const size_t stripes = (end - begin) / 64;
+  mix_stripes(state_->lanes_, state_->keys_, begin, stripes);
+  begin += 64 * stripes;
+  memcpy(state_->buffer_, begin, end - begin);
+}
+
+template <size_t K>
+multi_hash<K>::operator result_type() && {
+  // Pad the buffered input with zeros to a whole number of blocks, and mix
+  // it as a partial stripe; the length distinguishes the padding from input
+  // zeros.
+  const size_t buffered = len_ % 64;
+  if (buffered != 0) {
+    const size_t blocks = (buffered + 15) / 16;
+    memset(state_->buffer_ + buffered, 0, 16 * blocks - buffered);
+    switch (blocks) {
+      case 1: mix<1>(state_->lanes_, state_->keys_, state_->buffer_); break;
+      case 2: mix<2>(state_->lanes_, state_->keys_, state_->buffer_); break;
+      case 3: mix<3>(state_->lanes_, state_->keys_, state_->buffer_); break;
+      case 4: mix<4>(state_->lanes_, state_->keys_, state_->buffer_); break;
+    }
+  }
+  return finish_lanes(state_->lanes_, len_, std::make_index_sequence<K>());
+}
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_MULTI_HASH_H
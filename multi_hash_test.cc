@@ -0,0 +1,206 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "multi_hash.h"
+#include "std.h"
+
+namespace {
+
+template <size_t K, typename T>
+std::array<uint64_t, K> MultiHash(const T& t, uint64_t seed = 0) {
+  using std_::hash_value;
+  typename hashing::multi_hash<K>::state_type state;
+  return typename hashing::multi_hash<K>::result_type(
+      hash_value(hashing::multi_hash<K>{&state, seed}, t));
+}
+
+// Hashes 'bytes' by passing it to hash_combine_range in chunks of the
+// given sizes, followed by the rest.
+std::array<uint64_t, 4> HashInChunks(const std::string& bytes,
+                                     const std::vector<size_t>& chunks) {
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(bytes.data());
+  const unsigned char* const end = p + bytes.size();
+  hashing::multi_hash<4>::state_type state;
+  hashing::multi_hash<4> hash_code(&state);
+  for (size_t chunk : chunks) {
+    hash_code = hash_combine_range(std::move(hash_code), p, p + chunk);
+    p += chunk;
+  }
+  hash_code = hash_combine_range(std::move(hash_code), p, end);
+  return hashing::multi_hash<4>::result_type(std::move(hash_code));
+}
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+TEST(MultiHashTest, Deterministic) {
+  const auto key = std::make_tuple(42, std::string("abc"), 1.5);
+  EXPECT_EQ(MultiHash<4>(key), MultiHash<4>(key));
+  EXPECT_EQ(MultiHash<4>(key, 7), MultiHash<4>(key, 7));
+}
+
+TEST(MultiHashTest, LanesAndSeedsDiffer) {
+  for (int key : {0, 1, 42}) {
+    const auto hashes = MultiHash<8>(key);
+    const auto seeded = MultiHash<8>(key, 1);
+    std::set<uint64_t> distinct(hashes.begin(), hashes.end());
+    distinct.insert(seeded.begin(), seeded.end());
+    EXPECT_EQ(16, distinct.size()) << key;
+  }
+}
+
+TEST(MultiHashTest, LanesDoNotDependOnK) {
+  const std::string key = "the quick brown fox";
+  const auto two = MultiHash<2>(key);
+  const auto five = MultiHash<5>(key);
+  EXPECT_EQ(two[0], five[0]);
+  EXPECT_EQ(two[1], five[1]);
+}
+
+TEST(MultiHashTest, ChunkingDoesNotMatter) {
+  std::string bytes;
+  for (int i = 0; i < 100; ++i) {
+    bytes.push_back(static_cast<char>(i * 37));
+  }
+  const auto whole = HashInChunks(bytes, {});
+  EXPECT_EQ(whole, HashInChunks(bytes, {1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  EXPECT_EQ(whole, HashInChunks(bytes, {8, 16, 0, 3, 13}));
+  EXPECT_EQ(whole, HashInChunks(bytes, {99}));
+}
+
+// Each 16-byte block of a stripe is keyed by its position, and the stripes
+// are chained, so reordering the input changes every lane.
+TEST(MultiHashTest, BlockOrderMatters) {
+  std::string bytes;
+  for (int i = 0; i < 160; ++i) {
+    bytes.push_back(static_cast<char>(i / 16));
+  }
+  const auto original = HashInChunks(bytes, {});
+  for (int a = 0; a < 10; ++a) {
+    for (int b = a + 1; b < 10; ++b) {
+      std::string swapped = bytes;
+      swapped.replace(16 * a, 16, bytes, 16 * b, 16);
+      swapped.replace(16 * b, 16, bytes, 16 * a, 16);
+      const auto hashes = HashInChunks(swapped, {});
+      for (size_t i = 0; i < hashes.size(); ++i) {
+        EXPECT_NE(original[i], hashes[i])
+            << "blocks " << a << " and " << b << " lane " << i;
+      }
+    }
+  }
+}
+
+TEST(MultiHashTest, TrailingZerosChangeTheHash) {
+  const std::string bytes("abc\0\0\0\0\0\0", 9);
+  std::set<std::array<uint64_t, 4>> hashes;
+  for (size_t size = 0; size <= bytes.size(); ++size) {
+    hashes.insert(HashInChunks(bytes.substr(0, size), {}));
+  }
+  EXPECT_EQ(bytes.size() + 1, hashes.size());
+}
+
+constexpr uint64_t kMurmurMul = 0xc6a4a7935bd1e995ULL;
+
+// The unkeyed MurmurHash64A word scramble.
+uint64_t Scramble(uint64_t w) {
+  w *= kMurmurMul;
+  w ^= w >> 47;
+  return w * kMurmurMul;
+}
+
+// Returns the w for which Scramble(w) == s.
+uint64_t Unscramble(uint64_t s) {
+  // Newton's iteration for the inverse of kMurmurMul modulo 2^64; each
+  // step doubles the number of correct low bits, starting from 3.
+  uint64_t inverse = kMurmurMul;
+  for (int i = 0; i < 5; ++i) {
+    inverse *= 2 - kMurmurMul * inverse;
+  }
+  s *= inverse;
+  s ^= s >> 47;
+  return s * inverse;
+}
+
+// If every lane mixed in the same unkeyed scramble of each word, flipping
+// the top bit of two consecutive scrambled words would cancel out, and the
+// inputs would collide in every lane for every seed.
+TEST(MultiHashTest, TopBitDifferentialDoesNotCancel) {
+  const uint64_t kTopBit = uint64_t{1} << 63;
+  const uint64_t s1 = 0x0123456789abcdefULL;
+  const uint64_t s2 = 0xfedcba9876543210ULL;
+  const std::array<uint64_t, 2> a = {{Unscramble(s1), Unscramble(s2)}};
+  const std::array<uint64_t, 2> b = {
+      {Unscramble(s1 ^ kTopBit), Unscramble(s2 ^ kTopBit)}};
+
+  // Check that this is the differential: an unkeyed lane collides.
+  const uint64_t lane = 0x243f6a8885a308d3ULL;
+  EXPECT_EQ(((lane ^ Scramble(a[0])) * kMurmurMul ^ Scramble(a[1])),
+            ((lane ^ Scramble(b[0])) * kMurmurMul ^ Scramble(b[1])));
+
+  for (uint64_t seed : {0, 1, 12345}) {
+    const auto hash_a = MultiHash<8>(a, seed);
+    const auto hash_b = MultiHash<8>(b, seed);
+    for (size_t i = 0; i < hash_a.size(); ++i) {
+      EXPECT_NE(hash_a[i], hash_b[i]) << "seed " << seed << " lane " << i;
+    }
+  }
+}
+
+// Each bit of each lane should be uncorrelated with each bit of every
+// other lane; otherwise a Bloom filter using the lanes would have a higher
+// false positive rate than expected.
+TEST(MultiHashTest, LanesAreIndependent) {
+  constexpr size_t kLanes = 4;
+  constexpr int kSamples = 2000;
+  // About 6 standard deviations; see hash_quality_test.cc.
+  const double kMaxDeviation = 3.0 / std::sqrt(kSamples);
+
+  std::vector<std::array<uint64_t, kLanes>> samples;
+  for (int i = 0; i < kSamples; ++i) {
+    samples.push_back(MultiHash<kLanes>(SplitMix64(i)));
+  }
+  double worst = 0;
+  for (size_t a = 0; a < kLanes; ++a) {
+    for (size_t b = a + 1; b < kLanes; ++b) {
+      for (int i = 0; i < 64; ++i) {
+        for (int j = 0; j < 64; ++j) {
+          int agree = 0;
+          for (const auto& sample : samples) {
+            agree += ((sample[a] >> i) & 1) == ((sample[b] >> j) & 1);
+          }
+          worst = std::max(worst, std::abs(double(agree) / kSamples - 0.5));
+        }
+      }
+    }
+  }
+  EXPECT_LT(worst, kMaxDeviation);
+}
+
+}  // namespace
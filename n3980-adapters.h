@@ -0,0 +1,125 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Adapters between N3980 HashAlgorithms and this proposal's HashCodes, for
+// code bases that mix types with hash_append() overloads and types with
+// hash_value() overloads. Both APIs ultimately deliver contiguous byte
+// ranges to the algorithm, so each adapter simply forwards those ranges.
+
+#ifndef HASHING_DEMO_N3980_ADAPTERS_H
+#define HASHING_DEMO_N3980_ADAPTERS_H
+
+#include <cstddef>
+#include <utility>
+
+#include "n3980.h"
+#include "std_impl.h"
+
+namespace hashing {
+namespace n3980 {
+
+// HashCode that feeds its input to a HashAlgorithm, which it refers to but
+// does not own. This lets hash_value() overloads be used with an N3980
+// algorithm; see hash_append_via_hash_value() below. The hash value is
+// obtained from the algorithm, so this has no result_type.
+template <typename HashAlgorithm>
+class hash_code_adapter {
+  HashAlgorithm* h_;
+
+ public:
+  explicit hash_code_adapter(HashAlgorithm& h) : h_(&h) {}
+
+  hash_code_adapter(const hash_code_adapter&) = delete;
+  hash_code_adapter& operator=(const hash_code_adapter&) = delete;
+  hash_code_adapter(hash_code_adapter&&) = default;
+  hash_code_adapter& operator=(hash_code_adapter&&) = default;
+
+  template <typename... Ts>
+  friend hash_code_adapter hash_combine(
+      hash_code_adapter code, const Ts&... values) {
+    return std_::simple_hash_combine(std::move(code), values...);
+  }
+
+  template <typename InputIterator>
+  friend hash_code_adapter hash_combine_range(
+      hash_code_adapter code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(std::move(code), begin, end);
+  }
+
+  friend hash_code_adapter hash_combine_range(
+      hash_code_adapter code, const unsigned char* begin,
+      const unsigned char* end) {
+    (*code.h_)(begin, end - begin);
+    return code;
+  }
+};
+
+// HashAlgorithm that feeds its input to a HashCode, which it owns. This
+// lets hash_append() overloads be used with a HashCode; see
+// hash_value_via_hash_append() below.
+template <typename HashCode>
+class algorithm_adapter {
+  HashCode code_;
+
+ public:
+  using result_type = typename HashCode::result_type;
+
+  explicit algorithm_adapter(HashCode code) : code_(std::move(code)) {}
+
+  void operator()(const void* key, size_t length) {
+    const unsigned char* begin = static_cast<const unsigned char*>(key);
+    code_ = hash_combine_range(std::move(code_), begin, begin + length);
+  }
+
+  // Returns the HashCode, so that the caller can continue to combine
+  // values into it.
+  HashCode code() && { return std::move(code_); }
+
+  explicit operator result_type() && {
+    return result_type(std::move(code_));
+  }
+};
+
+// Appends 't' to 'h' using t's hash_value() overload. Types that only
+// provide hash_value() can implement hash_append() with this:
+//
+//   template <typename HashAlgorithm>
+//   void hash_append(HashAlgorithm& h, const MyType& t) {
+//     hashing::n3980::hash_append_via_hash_value(h, t);
+//   }
+template <typename HashAlgorithm, typename T>
+void hash_append_via_hash_value(HashAlgorithm& h, const T& t) {
+  using std_::hash_value;
+  hash_value(hash_code_adapter<HashAlgorithm>(h), t);
+}
+
+// Combines 't' into 'code' using t's hash_append() overload. Types that
+// only provide hash_append() can implement hash_value() with this:
+//
+//   template <typename HashCode>
+//   HashCode hash_value(HashCode code, const MyType& t) {
+//     return hashing::n3980::hash_value_via_hash_append(std::move(code), t);
+//   }
+template <typename HashCode, typename T>
+HashCode hash_value_via_hash_append(HashCode code, const T& t) {
+  using std_::hash_append;
+  algorithm_adapter<HashCode> h(std::move(code));
+  hash_append(h, t);
+  return std::move(h).code();
+}
+
+}  // namespace n3980
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_N3980_ADAPTERS_H
@@ -13,8 +13,8 @@
 // limitations under the License.
 
 // Extensions to namespace std to implement N3980. Not part of this proposal,
-// but implemented as a basis for comparison. Currently contains just enough
-// to get the benchmark working.
+// but implemented as a basis for comparison. Covers the same standard types
+// as the hash_value() overloads in std_impl.h.
 
 #ifndef HASHING_DEMO_N3980_H
 #define HASHING_DEMO_N3980_H
@@ -28,36 +28,112 @@ namespace std_ {
 
 using std::conditional_t;
 
+// Forward declarations, so that the overloads below can find each other
+// regardless of the order they are defined in. Argument-dependent lookup
+// doesn't help, because the argument types are in namespace std.
 template <typename HashAlgorithm, typename T0, typename T1, typename... Ts>
 void hash_append(HashAlgorithm& h, const T0& t0, const T1& t1,
                  const Ts&... ts);
 
-  template <typename HashAlgorithm, typename Integral>
+template <typename HashAlgorithm, typename T1, typename T2>
+void hash_append(HashAlgorithm& h, const pair<T1, T2>& p);
+
+template <typename HashAlgorithm, typename... Ts>
+void hash_append(HashAlgorithm& h, const tuple<Ts...>& t);
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const vector<T>& v);
+
+template <typename HashAlgorithm, typename T, size_t N>
+void hash_append(HashAlgorithm& h, const array<T, N>& a);
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const forward_list<T>& l);
+
+template <typename HashAlgorithm, typename T, typename D>
+void hash_append(HashAlgorithm& h, const unique_ptr<T, D>& p);
+
+// Each overload below appends the same bytes as the corresponding
+// hash_value() overload in std_impl.h, so that the two proposals do the
+// same work and can be compared directly. That is hash_value() applied to
+// the value itself, which hashes a tuple, say, element by element; it is
+// not hash_combine(), which hashes a uniquely represented value's object
+// representation in one piece, and so not std_::hash. For example, under
+// libstdc++, whose tuples store their elements in reverse order, a
+// tuple<int, int, int> gets a different FarmHash digest from std_::hash
+// than from hash_append().
+
+template <typename HashAlgorithm, typename Integral>
 enable_if_t<is_integral<Integral>::value || is_enum<Integral>::value>
 hash_append(HashAlgorithm& h, Integral value) {
   h(&value, sizeof(value));
 }
 
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, bool value) {
+  hash_append(h, static_cast<unsigned char>(value ? 1 : 0));
+}
+
+template <typename HashAlgorithm, typename Float>
+enable_if_t<is_floating_point<Float>::value>
+hash_append(HashAlgorithm& h, Float value) {
+  // Ensure that 0.0 and -0.0 hash the same.
+  const Float normalized = value == 0 ? 0 : value;
+  h(&normalized, sizeof(normalized));
+}
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, T* ptr) {
+  h(&ptr, sizeof(ptr));
+}
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, nullptr_t) {
+  hash_append(h, static_cast<unsigned char>(0));
+}
+
 template <typename HashAlgorithm>
 void hash_append(HashAlgorithm& h, const string& str) {
   h(str.data(), str.size());
   hash_append(h, str.size());
 }
 
+namespace detail {
+// Appends the members of 'p'. The last parameter is a dispatching tag that
+// indicates whether pair<T1, T2> is uniquely represented, in which case its
+// members are laid out contiguously with no padding, and can be appended
+// with a single call.
 template <typename HashAlgorithm, typename T1, typename T2>
-void hash_append(HashAlgorithm& h, const pair<T1, T2>& p) {
+void hash_append_pair(
+    HashAlgorithm& h, const pair<T1, T2>& p, std::true_type) {
+  h(&p, sizeof(p));
+}
+
+template <typename HashAlgorithm, typename T1, typename T2>
+void hash_append_pair(
+    HashAlgorithm& h, const pair<T1, T2>& p, std::false_type) {
   hash_append(h, p.first);
   hash_append(h, p.second);
 }
+}  // namespace detail
+
+template <typename HashAlgorithm, typename T1, typename T2>
+void hash_append(HashAlgorithm& h, const pair<T1, T2>& p) {
+  detail::hash_append_pair(h, p, is_uniquely_represented<pair<T1, T2>>{});
+}
 
 namespace detail {
 template <typename HashAlgorithm, typename Tuple, size_t... Is>
 void hash_append_tuple(
     HashAlgorithm& h, const Tuple& t, index_sequence<Is...>) {
-  hash_append(h, get<Is>(t)...);
+  (void)expand{0, (hash_append(h, get<Is>(t)), 0)...};
 }
 }  // namespace detail
 
+// Unlike pair, a uniquely-represented tuple is still appended one element
+// at a time: tuple implementations don't necessarily store the elements in
+// order (libstdc++ stores them in reverse), so its bytes would differ from
+// the concatenation of its elements' bytes.
 template <typename HashAlgorithm, typename... Ts>
 void hash_append(HashAlgorithm& h, const tuple<Ts...>& t) {
   detail::hash_append_tuple(h, t, make_index_sequence<sizeof...(Ts)>());
@@ -78,35 +154,70 @@ struct select_hash_iteration_strategy<vector<T>> {
                              hash_bytes_directly_tag, hash_by_iterating_tag>;
 };
 
+template <typename T, size_t N>
+struct select_hash_iteration_strategy<array<T, N>> {
+  using type = conditional_t<is_uniquely_represented<T>::value,
+                             hash_bytes_directly_tag, hash_by_iterating_tag>;
+};
+
 template <typename HashAlgorithm, typename C>
-void hash_append_container(
+void hash_append_elements(
     HashAlgorithm& h, const C& c, hash_bytes_directly_tag) {
   if (!c.empty()) {
     h(&*c.begin(), c.size() * sizeof(*c.begin()));
   }
-  hash_append(h, static_cast<size_t>(c.size()));
 }
 
 template <typename HashAlgorithm, typename C>
-void hash_append_container(
+void hash_append_elements(
     HashAlgorithm& h, const C& c, hash_by_iterating_tag) {
   for (const auto& v : c) {
     hash_append(h, v);
   }
 }
+
+// Following hash_sized_container in std_impl.h, appends the elements of
+// 'c' followed by its size, as a size_t.
+template <typename HashAlgorithm, typename C>
+void hash_append_container(HashAlgorithm& h, const C& c) {
+  hash_append_elements(
+      h, c, typename select_hash_iteration_strategy<C>::type());
+  hash_append(h, static_cast<size_t>(c.size()));
+}
 }  // namespace detail
 
 template <typename HashAlgorithm, typename T>
 void hash_append(HashAlgorithm& h, const vector<T>& v) {
-  detail::hash_append_container(
-      h, v, typename detail::select_hash_iteration_strategy<vector<T>>::type());
+  detail::hash_append_container(h, v);
+}
+
+template <typename HashAlgorithm, typename T, size_t N>
+void hash_append(HashAlgorithm& h, const array<T, N>& a) {
+  detail::hash_append_container(h, a);
+}
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const forward_list<T>& l) {
+  // As in std_impl.h, compute the size during the traversal.
+  size_t size = 0;
+  for (const T& t : l) {
+    hash_append(h, t);
+    ++size;
+  }
+  hash_append(h, size);
+}
+
+template <typename HashAlgorithm, typename T, typename D>
+void hash_append(HashAlgorithm& h, const unique_ptr<T, D>& p) {
+  hash_append(h, p.get());
 }
 
 template <typename HashAlgorithm, typename T0, typename T1, typename... Ts>
 void hash_append(HashAlgorithm& h, const T0& t0, const T1& t1,
                  const Ts&... ts) {
   hash_append(h, t0);
-  hash_append(h, t1, ts...);
+  hash_append(h, t1);
+  (void)detail::expand{0, (hash_append(h, ts), 0)...};
 }
 
 template <typename H>
@@ -0,0 +1,215 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that N3980's hash_append() feeds a hash algorithm exactly the
+// bytes that this proposal's hash_value() does, for each standard type
+// both support, so that benchmarks comparing them are apples-to-apples.
+
+#include <array>
+#include <forward_list>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "debug.h"
+#include "farmhash.h"
+#include "n3980.h"
+#include "n3980-adapters.h"
+#include "n3980-farmhash.h"
+#include "std.h"
+
+namespace {
+
+// N3980 HashAlgorithm that records its input, like hashing::identity.
+class recorder {
+  std::string input_;
+
+ public:
+  using result_type = std::string;
+
+  void operator()(const void* key, size_t length) {
+    input_.append(static_cast<const char*>(key), length);
+  }
+
+  explicit operator result_type() { return input_; }
+};
+
+template <typename T>
+std::string HashAppendInput(const T& value) {
+  return std_::uhash<recorder>()(value);
+}
+
+template <typename T>
+std::string HashValueInput(const T& value) {
+  using std_::hash_value;
+  return hashing::identity::result_type(
+      hash_value(hashing::identity(), value));
+}
+
+template <typename T>
+void ExpectSameInput(const T& value, const char* expression) {
+  EXPECT_EQ(HashValueInput(value), HashAppendInput(value)) << expression;
+}
+
+#define EXPECT_SAME_INPUT(value) ExpectSameInput(value, #value)
+
+TEST(N3980Test, Scalars) {
+  EXPECT_SAME_INPUT(42);
+  EXPECT_SAME_INPUT(static_cast<unsigned char>(7));
+  EXPECT_SAME_INPUT(std::numeric_limits<long long>::min());
+  EXPECT_SAME_INPUT(true);
+  EXPECT_SAME_INPUT(false);
+  EXPECT_SAME_INPUT(1.5);
+  EXPECT_SAME_INPUT(-2.5f);
+  int i = 0;
+  EXPECT_SAME_INPUT(&i);
+  EXPECT_SAME_INPUT(nullptr);
+}
+
+TEST(N3980Test, FloatingPointZeroesAreEquivalent) {
+  EXPECT_EQ(HashAppendInput(0.0), HashAppendInput(-0.0));
+  EXPECT_EQ(HashAppendInput(0.0f), HashAppendInput(-0.0f));
+}
+
+TEST(N3980Test, PairsAndTuples) {
+  // Uniquely represented, so appended in one call.
+  EXPECT_SAME_INPUT(std::make_pair(1, 2));
+  // Padded, so appended member by member.
+  EXPECT_SAME_INPUT(std::make_pair('a', 2));
+  EXPECT_SAME_INPUT(std::make_tuple());
+  EXPECT_SAME_INPUT(std::make_tuple(1, 2, 3));
+  EXPECT_SAME_INPUT(std::make_tuple(1, 2.5, std::string("abc"), true));
+}
+
+TEST(N3980Test, Containers) {
+  EXPECT_SAME_INPUT(std::string());
+  EXPECT_SAME_INPUT(std::string("abc"));
+  EXPECT_SAME_INPUT(std::vector<int>());
+  EXPECT_SAME_INPUT(std::vector<int>({1, 2, 3}));
+  EXPECT_SAME_INPUT(std::vector<double>({1.0, -0.0}));
+  EXPECT_SAME_INPUT(
+      (std::vector<std::pair<char, int>>({{'a', 1}, {'b', 2}})));
+  EXPECT_SAME_INPUT((std::array<int, 0>()));
+  EXPECT_SAME_INPUT((std::array<int, 3>{{1, 2, 3}}));
+  EXPECT_SAME_INPUT((std::array<bool, 2>{{true, false}}));
+  EXPECT_SAME_INPUT(std::forward_list<int>());
+  EXPECT_SAME_INPUT(std::forward_list<int>({1, 2, 3}));
+  EXPECT_SAME_INPUT(
+      std::vector<std::vector<std::string>>({{"a", "bc"}, {}, {"def"}}));
+}
+
+TEST(N3980Test, UniquePtr) {
+  EXPECT_SAME_INPUT(std::unique_ptr<int>());
+  EXPECT_SAME_INPUT(std::unique_ptr<int>(new int(3)));
+}
+
+// The same input must give the same digest from each proposal's FarmHash.
+template <typename T>
+void ExpectSameFarmhash(const T& value, const char* expression) {
+  using std_::hash_value;
+  hashing::farmhash::state_type state;
+  EXPECT_EQ(size_t(hashing::farmhash::result_type(
+                hash_value(hashing::farmhash{&state}, value))),
+            std_::uhash<hashing::n3980::farmhash>()(value))
+      << expression;
+}
+
+#define EXPECT_SAME_FARMHASH(value) ExpectSameFarmhash(value, #value)
+
+TEST(N3980Test, SameFarmhashDigests) {
+  EXPECT_SAME_FARMHASH(42);
+  EXPECT_SAME_FARMHASH(-0.0);
+  EXPECT_SAME_FARMHASH(std::make_pair(1, 2));
+  EXPECT_SAME_FARMHASH(std::make_pair('a', 2));
+  EXPECT_SAME_FARMHASH(std::make_tuple(1, 2, 3));
+  EXPECT_SAME_FARMHASH(std::make_tuple(1, 2.5, std::string("abc"), true));
+  EXPECT_SAME_FARMHASH(std::string("abc"));
+  EXPECT_SAME_FARMHASH(std::string(200, 'x'));
+  EXPECT_SAME_FARMHASH(std::vector<int>({1, 2, 3}));
+  EXPECT_SAME_FARMHASH((std::array<int, 3>{{1, 2, 3}}));
+  EXPECT_SAME_FARMHASH(
+      std::vector<std::vector<std::string>>({{"a", "bc"}, {}, {"def"}}));
+}
+
+TEST(N3980Test, ContainerSizeDisambiguates) {
+  // Without the size, these would both append "a", "b", "c".
+  using Strings = std::vector<std::string>;
+  EXPECT_NE(HashAppendInput(std::make_pair(Strings{"a"}, Strings{"b", "c"})),
+            HashAppendInput(std::make_pair(Strings{"a", "b"}, Strings{"c"})));
+}
+
+// Types that each provide only one of the two extension points, and get
+// the other through an adapter.
+struct OnlyHashValue {
+  std::vector<int> v;
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode code, const OnlyHashValue& x) {
+    return hash_combine(std::move(code), x.v);
+  }
+
+  template <typename HashAlgorithm>
+  friend void hash_append(HashAlgorithm& h, const OnlyHashValue& x) {
+    hashing::n3980::hash_append_via_hash_value(h, x);
+  }
+};
+
+struct OnlyHashAppend {
+  std::vector<int> v;
+
+  template <typename HashAlgorithm>
+  friend void hash_append(HashAlgorithm& h, const OnlyHashAppend& x) {
+    using std_::hash_append;
+    hash_append(h, x.v);
+  }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode code, const OnlyHashAppend& x) {
+    return hashing::n3980::hash_value_via_hash_append(std::move(code), x);
+  }
+};
+
+TEST(N3980AdapterTest, HashCodeAdapterForwardsInput) {
+  const auto value =
+      std::make_tuple(1, 2.5, std::string("abc"), std::vector<int>({1, 2}));
+  recorder h;
+  hashing::n3980::hash_append_via_hash_value(h, value);
+  EXPECT_EQ(HashValueInput(value), std::string(h));
+}
+
+TEST(N3980AdapterTest, AlgorithmAdapterForwardsInput) {
+  const auto value =
+      std::make_tuple(1, 2.5, std::string("abc"), std::vector<int>({1, 2}));
+  EXPECT_EQ(HashAppendInput(value),
+            hashing::identity::result_type(
+                hashing::n3980::hash_value_via_hash_append(
+                    hashing::identity(), value)));
+}
+
+TEST(N3980AdapterTest, AdaptedTypesHashLikeTheirContents) {
+  const std::vector<int> v = {1, 2, 3};
+  EXPECT_EQ(HashAppendInput(v), HashAppendInput(OnlyHashValue{v}));
+  EXPECT_EQ(HashValueInput(v), HashValueInput(OnlyHashAppend{v}));
+  EXPECT_EQ(std_::hash<std::vector<int>>()(v),
+            std_::hash<OnlyHashAppend>()(OnlyHashAppend{v}));
+  EXPECT_EQ(std_::uhash<hashing::n3980::farmhash>()(v),
+            std_::uhash<hashing::n3980::farmhash>()(OnlyHashValue{v}));
+}
+
+}  // namespace
@@ -15,6 +15,7 @@
 #include "pimpl.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 class Impl {
@@ -23,16 +24,68 @@ class Impl {
 
  public:
   Impl() {}
+  Impl(std::vector<int> v, std::string s)
+      : v_(std::move(v)), s_(std::move(s)) {}
+
+  friend bool operator==(const Impl& lhs, const Impl& rhs) {
+    return lhs.v_ == rhs.v_ && lhs.s_ == rhs.s_;
+  }
+
+  template <typename HashCode>
+  static HashCode hash_contents(HashCode hash_code, const Impl& impl) {
+    return hash_combine(std::move(hash_code), impl.v_, impl.s_);
+  }
 
   friend hashing::type_erased_hash_code hash_value(
       hashing::type_erased_hash_code hash_code, const Impl& impl);
+
+  // Used by memoized_hash<Impl>, which hashes with std_::hash_code directly
+  // rather than through type erasure.
+  friend std_::hash_code hash_value(
+      std_::hash_code hash_code, const Impl& impl) {
+    return hash_contents(std::move(hash_code), impl);
+  }
 };
 
 hashing::type_erased_hash_code hash_value(
     hashing::type_erased_hash_code hash_code, const Impl& impl) {
-  return hash_combine(std::move(hash_code), impl.v_, impl.s_);
+  return Impl::hash_contents(std::move(hash_code), impl);
 }
 
 Pimpl::Pimpl() :impl_(std::make_unique<Impl>()) {}
 
+Pimpl::Pimpl(std::vector<int> v, std::string s)
+    : impl_(std::make_unique<Impl>(std::move(v), std::move(s))) {}
+
+Pimpl::Pimpl(Pimpl&&) = default;
+
+Pimpl& Pimpl::operator=(Pimpl&&) = default;
+
 Pimpl::~Pimpl() {}
+
+bool operator==(const Pimpl& lhs, const Pimpl& rhs) {
+  return *lhs.impl_ == *rhs.impl_;
+}
+
+CachedPimpl::CachedPimpl()
+    : impl_(std::make_unique<const hashing::memoized_hash<Impl>>()) {}
+
+CachedPimpl::CachedPimpl(std::vector<int> v, std::string s)
+    : impl_(std::make_unique<const hashing::memoized_hash<Impl>>(
+          std::move(v), std::move(s))) {}
+
+CachedPimpl::CachedPimpl(CachedPimpl&&) = default;
+
+CachedPimpl& CachedPimpl::operator=(CachedPimpl&&) = default;
+
+CachedPimpl::~CachedPimpl() {}
+
+bool operator==(const CachedPimpl& lhs, const CachedPimpl& rhs) {
+  return lhs.impl_->hash() == rhs.impl_->hash() &&
+         lhs.impl_->value() == rhs.impl_->value();
+}
+
+hashing::type_erased_hash_code hash_value(
+    hashing::type_erased_hash_code hash_code, const CachedPimpl& pimpl) {
+  return hash_value(std::move(hash_code), *pimpl.impl_);
+}
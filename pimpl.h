@@ -15,8 +15,12 @@
 #ifndef HASHING_DEMO_PIMPL_H
 #define HASHING_DEMO_PIMPL_H
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "memoized_hash.h"
 #include "type_erased_hash_code.h"
 
 class Impl;
@@ -28,8 +32,13 @@ class Pimpl {
 
  public:
   Pimpl();
+  Pimpl(std::vector<int> v, std::string s);
+  Pimpl(Pimpl&&);
+  Pimpl& operator=(Pimpl&&);
   ~Pimpl();
 
+  friend bool operator==(const Pimpl& lhs, const Pimpl& rhs);
+
   template <typename HashCode>
   friend HashCode hash_value(HashCode hash_code, const Pimpl& pimpl) {
     hash_value(hashing::type_erased_hash_code(&hash_code), *pimpl.impl_);
@@ -37,4 +46,33 @@ class Pimpl {
   }
 };
 
+// Variant of Pimpl for large immutable objects that are hashed repeatedly,
+// e.g. as map keys. The Impl's std_::hash_code digest is computed once and
+// stored next to it, and hash_value() mixes in only that digest. See
+// memoized_hash.h for the trade-offs this implies.
+class CachedPimpl {
+  std::unique_ptr<const hashing::memoized_hash<Impl>> impl_;
+
+ public:
+  CachedPimpl();
+  CachedPimpl(std::vector<int> v, std::string s);
+  CachedPimpl(CachedPimpl&&);
+  CachedPimpl& operator=(CachedPimpl&&);
+  ~CachedPimpl();
+
+  // Compares the cached digests before the contents.
+  friend bool operator==(const CachedPimpl& lhs, const CachedPimpl& rhs);
+
+  // Forwards to memoized_hash's hash_value, which needs Impl to be
+  // complete, so this goes through type erasure as Pimpl does.
+  friend hashing::type_erased_hash_code hash_value(
+      hashing::type_erased_hash_code hash_code, const CachedPimpl& pimpl);
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const CachedPimpl& pimpl) {
+    hash_value(hashing::type_erased_hash_code(&hash_code), pimpl);
+    return std::move(hash_code);
+  }
+};
+
 #endif  // HASHING_DEMO_PIMPL_H
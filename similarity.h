@@ -0,0 +1,224 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Similarity signatures for near-duplicate detection, over sequences of
+// any type that std_::hash supports. Each token is hashed once.
+//
+// minhash<K>() computes a K-value MinHash signature of the set of tokens,
+// using one-permutation hashing with densification, and
+// estimate_jaccard() estimates the Jaccard similarity of two sets from
+// their signatures. simhash() computes a 64-bit SimHash fingerprint of the
+// multiset of tokens, whose Hamming distance to another estimates their
+// angular distance. lsh_index finds the documents whose MinHash
+// signatures are likely to be similar to a query's, by banding.
+//
+//   std::vector<std::string> words = ...;
+//   const auto signature = hashing::minhash<128>(words.begin(), words.end());
+//   hashing::lsh_index<32, 4> index;
+//   index.insert(id, signature);
+//   for (size_t candidate : index.candidates(other_signature)) ...
+
+#ifndef HASHING_DEMO_SIMILARITY_H
+#define HASHING_DEMO_SIMILARITY_H
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "farmhash.h"
+#include "std.h"
+
+namespace hashing {
+
+template <size_t K>
+using minhash_signature = std::array<uint64_t, K>;
+
+namespace detail {
+
+inline uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Maps the high 32 bits of 'h' uniformly onto [0, n).
+inline size_t ReduceTo(uint64_t h, size_t n) {
+  return static_cast<size_t>(((h >> 32) * n) >> 32);
+}
+
+template <typename InputIterator>
+uint64_t HashToken(InputIterator it) {
+  using T = typename std::iterator_traits<InputIterator>::value_type;
+  return std_::hash<T>{}(*it);
+}
+
+}  // namespace detail
+
+// Returns the MinHash signature of the set of tokens in [begin, end). Each
+// token's hash picks one of K bins, which keeps the smallest hash that
+// falls into it (one-permutation hashing), so the cost is independent of
+// K. Bins that no token falls into, which are common for sets not much
+// larger than K, are then filled from a pseudo-randomly chosen non-empty
+// bin (optimal densification), so that every position of two signatures
+// still agrees with probability equal to the sets' Jaccard similarity.
+// The signature of an empty set has every value equal to the maximum.
+template <size_t K, typename InputIterator>
+minhash_signature<K> minhash(InputIterator begin, InputIterator end) {
+  static_assert(K > 0 && K <= (size_t{1} << 32),
+                "minhash requires between 1 and 2^32 bins");
+  minhash_signature<K> bins;
+  bins.fill(std::numeric_limits<uint64_t>::max());
+  std::bitset<K> filled;
+  for (; begin != end; ++begin) {
+    const uint64_t h = detail::HashToken(begin);
+    const size_t bin = detail::ReduceTo(h, K);
+    bins[bin] = std::min(bins[bin], h);
+    filled.set(bin);
+  }
+  if (filled.all() || filled.none()) {
+    return bins;
+  }
+
+  // The probe sequence for each bin depends only on the bin, so that two
+  // sets agree on an empty bin exactly when they agree on the bin it is
+  // filled from.
+  minhash_signature<K> signature = bins;
+  for (size_t i = 0; i < K; ++i) {
+    if (filled[i]) continue;
+    for (uint64_t attempt = 1;; ++attempt) {
+      const size_t j =
+          detail::ReduceTo(detail::SplitMix64(i * 0x100000001ULL + attempt), K);
+      if (filled[j]) {
+        signature[i] = bins[j];
+        break;
+      }
+    }
+  }
+  return signature;
+}
+
+// Returns the fraction of positions at which the signatures agree, which
+// estimates the Jaccard similarity of the sets they were computed from.
+template <size_t K>
+double estimate_jaccard(const minhash_signature<K>& a,
+                        const minhash_signature<K>& b) {
+  size_t matches = 0;
+  for (size_t i = 0; i < K; ++i) {
+    matches += a[i] == b[i];
+  }
+  return static_cast<double>(matches) / K;
+}
+
+// Returns the SimHash fingerprint of the tokens in [begin, end), counting
+// repeated tokens each time: bit b of the result is set if bit b is set in
+// more than half of the token hashes.
+//
+// Rather than keeping 64 separate counters, this keeps them bit-sliced:
+// bit b of counters[i] is bit i of the count for bit position b. Adding a
+// token's hash to all 64 counts at once is then a ripple-carry addition
+// across the counters, which takes two operations per counter that the
+// carry reaches, and on average the carry only reaches two.
+template <typename InputIterator>
+uint64_t simhash(InputIterator begin, InputIterator end) {
+  uint64_t counters[64] = {};
+  // The number of counters that have been used.
+  int num_counters = 0;
+  uint64_t num_tokens = 0;
+  for (; begin != end; ++begin) {
+    uint64_t carry = detail::HashToken(begin);
+    int i = 0;
+    for (; carry != 0; ++i) {
+      const uint64_t sum = counters[i] ^ carry;
+      carry &= counters[i];
+      counters[i] = sum;
+    }
+    num_counters = std::max(num_counters, i);
+    ++num_tokens;
+  }
+
+  uint64_t result = 0;
+  for (int b = 0; b < 64; ++b) {
+    uint64_t count = 0;
+    for (int i = 0; i < num_counters; ++i) {
+      count |= ((counters[i] >> b) & 1) << i;
+    }
+    result |= static_cast<uint64_t>(2 * count > num_tokens) << b;
+  }
+  return result;
+}
+
+// Returns the fraction of bits on which two SimHash fingerprints agree.
+inline double simhash_similarity(uint64_t a, uint64_t b) {
+  return 1.0 - std::bitset<64>(a ^ b).count() / 64.0;
+}
+
+// Index of MinHash signatures for finding candidate near-duplicates. Each
+// signature of Bands * Rows values is split into Bands bands of Rows
+// values, and two signatures are candidates if they agree on every value
+// of any band. Sets with Jaccard similarity s become candidates with
+// probability 1 - (1 - s^Rows)^Bands, which rises steeply around
+// (1 / Bands)^(1 / Rows); choose Bands and Rows to put that threshold at
+// the similarity of interest. Candidates should then be confirmed with
+// estimate_jaccard() or an exact comparison.
+template <size_t Bands, size_t Rows>
+class lsh_index {
+ public:
+  using signature = minhash_signature<Bands * Rows>;
+
+  // Adds document 'id' with the given signature.
+  void insert(size_t id, const signature& s) {
+    for (size_t band = 0; band < Bands; ++band) {
+      buckets_[band][band_hash(s, band)].push_back(id);
+    }
+  }
+
+  // Returns the documents that share at least one band with 's', in
+  // increasing order of id, each once.
+  std::vector<size_t> candidates(const signature& s) const {
+    std::vector<size_t> result;
+    for (size_t band = 0; band < Bands; ++band) {
+      const auto it = buckets_[band].find(band_hash(s, band));
+      if (it != buckets_[band].end()) {
+        result.insert(result.end(), it->second.begin(), it->second.end());
+      }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+ private:
+  // Bands whose values differ may still collide here, which only adds
+  // false candidates.
+  static uint64_t band_hash(const signature& s, size_t band) {
+    const uint64_t* values = s.data() + band * Rows;
+    farmhash::state_type state;
+    return farmhash::result_type(
+        hash_combine_range(farmhash{&state}, values, values + Rows));
+  }
+
+  // The keys are already hashes, so std::hash suffices.
+  std::unordered_map<uint64_t, std::vector<size_t>> buckets_[Bands];
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_SIMILARITY_H
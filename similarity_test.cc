@@ -0,0 +1,144 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "similarity.h"
+
+namespace {
+
+// Returns the integers in [begin, end).
+std::vector<int> Range(int begin, int end) {
+  std::vector<int> result;
+  for (int i = begin; i < end; ++i) {
+    result.push_back(i);
+  }
+  return result;
+}
+
+template <size_t K, typename Container>
+hashing::minhash_signature<K> MinHash(const Container& tokens) {
+  return hashing::minhash<K>(tokens.begin(), tokens.end());
+}
+
+template <typename Container>
+uint64_t SimHash(const Container& tokens) {
+  return hashing::simhash(tokens.begin(), tokens.end());
+}
+
+TEST(MinHashTest, DependsOnlyOnTheSet) {
+  std::vector<std::string> words = {"the", "quick", "brown", "fox", "jumps"};
+  const auto signature = MinHash<64>(words);
+  std::reverse(words.begin(), words.end());
+  words.push_back("the");
+  EXPECT_EQ(signature, MinHash<64>(words));
+}
+
+TEST(MinHashTest, DensificationFillsEveryBin) {
+  const std::vector<int> tokens = {1, 2, 3};
+  for (uint64_t value : MinHash<256>(tokens)) {
+    EXPECT_NE(std::numeric_limits<uint64_t>::max(), value);
+  }
+  EXPECT_EQ(1.0, hashing::estimate_jaccard(MinHash<256>(tokens),
+                                           MinHash<256>(tokens)));
+}
+
+TEST(MinHashTest, EmptySet) {
+  const std::vector<int> empty;
+  for (uint64_t value : MinHash<16>(empty)) {
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), value);
+  }
+}
+
+TEST(MinHashTest, EstimatesJaccardSimilarity) {
+  // Sets of 1000 integers, overlapping in 'overlap' of them, have Jaccard
+  // similarity overlap / (2000 - overlap).
+  const std::vector<int> a = Range(0, 1000);
+  for (int overlap : {0, 200, 500, 800, 1000}) {
+    const std::vector<int> b = Range(1000 - overlap, 2000 - overlap);
+    const double expected = overlap / (2000.0 - overlap);
+    EXPECT_NEAR(expected,
+                hashing::estimate_jaccard(MinHash<512>(a), MinHash<512>(b)),
+                0.07)
+        << overlap;
+  }
+}
+
+TEST(MinHashTest, EstimatesJaccardSimilarityOfSmallSets) {
+  // Smaller than the number of bins, so most bins are densified.
+  const std::vector<int> a = Range(0, 40);
+  const std::vector<int> b = Range(20, 60);
+  EXPECT_NEAR(1.0 / 3,
+              hashing::estimate_jaccard(MinHash<512>(a), MinHash<512>(b)),
+              0.1);
+}
+
+TEST(MinHashTest, AcceptsAnyHashableToken) {
+  const std::vector<std::pair<std::string, int>> tokens = {
+      {"a", 1}, {"b", 2}, {"c", 3}};
+  const std::vector<std::tuple<double, bool>> other_tokens = {
+      std::make_tuple(0.5, true)};
+  EXPECT_NE(MinHash<8>(tokens), MinHash<8>(other_tokens));
+}
+
+TEST(SimHashTest, Deterministic) {
+  const std::vector<std::string> words = {"near", "duplicate", "detection"};
+  EXPECT_EQ(SimHash(words), SimHash(words));
+  EXPECT_EQ(0u, SimHash(std::vector<int>()));
+  // A single token's fingerprint is its hash.
+  EXPECT_EQ(std_::hash<int>{}(42), SimHash(std::vector<int>{42}));
+}
+
+TEST(SimHashTest, CountsRepeatedTokens) {
+  const std::vector<int> once = {1, 2};
+  const std::vector<int> twice = {1, 1, 2};
+  // With two tokens, a bit is only set if both hashes set it; repeating
+  // token 1 makes its bits win.
+  EXPECT_EQ(std_::hash<int>{}(1) & std_::hash<int>{}(2), SimHash(once));
+  EXPECT_EQ(std_::hash<int>{}(1), SimHash(twice));
+}
+
+TEST(SimHashTest, SimilarDocumentsHaveSimilarFingerprints) {
+  const std::vector<int> a = Range(0, 1000);
+  const std::vector<int> near = Range(10, 1010);
+  const std::vector<int> far = Range(5000, 6000);
+  EXPECT_GT(hashing::simhash_similarity(SimHash(a), SimHash(near)), 0.85);
+  EXPECT_LT(hashing::simhash_similarity(SimHash(a), SimHash(far)), 0.75);
+}
+
+TEST(LshIndexTest, FindsNearDuplicates) {
+  hashing::lsh_index<32, 4> index;
+  // Document i is [100 * i, 100 * i + 100), except that document 7 is a
+  // near-duplicate of document 3.
+  for (size_t i = 0; i < 20; ++i) {
+    const int begin = i == 7 ? 302 : 100 * i;
+    index.insert(i, MinHash<128>(Range(begin, begin + 100)));
+  }
+  EXPECT_EQ(std::vector<size_t>({3, 7}),
+            index.candidates(MinHash<128>(Range(301, 401))));
+  EXPECT_EQ(std::vector<size_t>({12}),
+            index.candidates(MinHash<128>(Range(1200, 1300))));
+  EXPECT_EQ(std::vector<size_t>(),
+            index.candidates(MinHash<128>(Range(5000, 5100))));
+}
+
+}  // namespace
@@ -16,6 +16,7 @@
 #define HASHING_DEMO_STD_H
 
 #include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <unordered_set>
@@ -33,31 +34,87 @@ namespace std_ {
 using hash_code = hashing::farmhash;
 
 namespace detail {
-// Trait class that detects whether hash_value(std::hash_code, T) is
+// Trait class that detects whether hash_value(HashCode, T) is
 // well-formed, for use in the SFINAE logic below.
+template <typename HashCode, typename T, typename = void>
+struct supports_hash_value_for : public false_type {};
+
+template <typename HashCode, typename T>
+struct supports_hash_value_for<
+    HashCode, T,
+    void_t<decltype(hash_value(declval<HashCode>(), declval<T>()))>>
+    : public true_type {};
+
+template <typename T>
+using supports_hash_value = supports_hash_value_for<hash_code, T>;
+
+// Trait class that detects whether T can be hashed by
+// hashing::farmhash_fixed_size(), which requires that its fixed_hash_size
+// is known and at most 64, and that it is uniquely represented or has a
+// hash_value() for hashing::farmhash_fixed_input.
 template <typename T, typename = void>
-struct supports_hash_value : public false_type {};
+struct use_fixed_size_hash : public false_type {};
 
 template <typename T>
-struct supports_hash_value<
-    T, void_t<decltype(hash_value(declval<hash_code>(), declval<T>()))>>
+struct use_fixed_size_hash<
+    T, enable_if_t<(fixed_hash_size<T>::value <= 64) &&
+                   (is_uniquely_represented<T>::value ||
+                    supports_hash_value_for<hashing::farmhash_fixed_input,
+                                            T>::value)>>
     : public true_type {};
 
 }  // namespace detail
 
 template <typename T>
 struct hash {
-  // Make operator() SFINAE-friendly
+  // Make operator() SFINAE-friendly. Like std::hash, this is const, so that
+  // the standard containers can call it, and does not throw.
   template <typename U = T>
   enable_if_t<detail::supports_hash_value<U>::value,
               size_t>
-  operator()(const U& u) {
+  operator()(const U& u) const noexcept {
+    return hash_impl(u, detail::use_fixed_size_hash<U>());
+  }
+
+ private:
+  // Types with a short fixed hashed length skip the streaming state.
+  template <typename U>
+  static size_t hash_impl(const U& u, true_type) {
+    return hashing::farmhash_fixed_size(u);
+  }
+
+  template <typename U>
+  static size_t hash_impl(const U& u, false_type) {
     hashing::farmhash::state_type state;
     return hashing::farmhash::result_type(
         hash_combine(hashing::farmhash{&state}, u));
   }
+
+  // So do short strings, which are the most common string keys.
+  static size_t hash_impl(const string& s, false_type) {
+    if (s.size() <= hashing::kFarmhashMaxShortString) {
+      return hashing::farmhash_short_string(s.data(), s.size());
+    }
+    hashing::farmhash::state_type state;
+    return hashing::farmhash::result_type(
+        hash_combine(hashing::farmhash{&state}, s));
+  }
 };
 
+// Trait that determines whether unordered containers using hash<T> store
+// each element's hash code in its node. Caching costs a word per node, but
+// saves rehashing the element when the table grows, and lets lookups skip
+// comparing elements whose hash codes differ. By default, hash codes are
+// cached unless T is uniquely represented, in which case hashing it is as
+// cheap as comparing it. Specialize this to choose otherwise for a type.
+//
+// This is currently only implemented for libstdc++, which otherwise caches
+// hash codes only for hashers it considers slow, such as std::hash of a
+// string. Other standard libraries decide for themselves.
+template <typename T>
+struct cache_hash_code
+    : public integral_constant<bool, !is_uniquely_represented<T>::value> {};
+
 // std_::unordered set uses std_::hash by default. The other unordered
 // containers could be aliased similarly.
 template <typename Key,
@@ -68,4 +125,20 @@ using unordered_set = std::unordered_set<Key, Hash, KeyEqual, Allocator>;
 
 }  // namespace std_
 
+#ifdef __GLIBCXX__
+namespace std {
+
+// libstdc++ caches hash codes in unordered container nodes unless the
+// hasher is noexcept and this trait is true. __is_fast_hash is a reserved
+// libstdc++ internal, not a documented extension point, so a future
+// version may rename it or stop consulting it; std_test checks the
+// resulting policy through std::__cache_default, and fails to compile if
+// it changes.
+template <typename T>
+struct __is_fast_hash<std_::hash<T>>
+    : public integral_constant<bool, !std_::cache_hash_code<T>::value> {};
+
+}  // namespace std
+#endif
+
 #endif  // HASHING_DEMO_STD_H
@@ -19,10 +19,15 @@
 // to be usable by std_::hash should include this header rather than
 // std.h, to avoid circular dependencies.
 
+#include <array>
 #include <cstddef>
 #include <forward_list>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace std_ {
@@ -85,26 +90,35 @@ struct is_uniquely_represented<T, enable_if_t<is_enum<T>::value>>
     : public true_type {};
 
 namespace detail {
-template <typename... Ts>
-struct all_uniquely_represented;
+// Evaluates a pack expansion in order, as in
+//   (void)expand{0, (f(ts), 0)...};
+// This stands in for C++17 fold expressions: unlike the equivalent
+// variadic recursion, it needs no extra template instantiations per
+// element, which matters for compile times with long argument lists.
+using expand = int[];
 
-template <typename T, typename... Ts>
-struct all_uniquely_represented<T, Ts...>
-    : public integral_constant<bool,
-                               is_uniquely_represented<T>::value &&
-                                   all_uniquely_represented<Ts...>::value> {};
-template <>
-struct all_uniquely_represented<> : public true_type {};
+template <bool... Bs>
+struct bool_pack;
 
 template <typename... Ts>
-struct cumulative_size;
+struct all_uniquely_represented
+    : public std::is_same<
+          bool_pack<true, is_uniquely_represented<Ts>::value...>,
+          bool_pack<is_uniquely_represented<Ts>::value..., true>> {};
+
+template <size_t N>
+constexpr size_t sum(const size_t (&values)[N]) {
+  size_t total = 0;
+  for (size_t value : values) {
+    total += value;
+  }
+  return total;
+}
 
-template <typename T, typename... Ts>
-struct cumulative_size<T, Ts...>
+template <typename... Ts>
+struct cumulative_size
     : public integral_constant<size_t,
-                               sizeof(T) + cumulative_size<Ts...>::value> {};
-template <>
-struct cumulative_size<> : public integral_constant<size_t, 0> {};
+                               sum<sizeof...(Ts) + 1>({0, sizeof(Ts)...})> {};
 }  // namespace detail
 
 template <typename T, typename U>
@@ -179,8 +193,8 @@ HashCode hash_value(HashCode code, T* ptr) {
 }
 
 template <typename HashCode>
-HashCode hash_value(HashCode code, nullptr_t p) {
-  return hash_combine(code, static_cast<unsigned char>(0));
+HashCode hash_value(HashCode code, nullptr_t) {
+  return hash_combine(std::move(code), static_cast<unsigned char>(0));
 }
 
 template <typename HashCode, typename T>
@@ -270,13 +284,9 @@ inline const char* adl_pointer_from(string::const_iterator i) { return &*i; }
 // Convenience helper functions for implementing hash algorithms
 // ==========================================================================
 
-// Forward declarations for the mutual recursion below.
-template <typename HashCode>
-HashCode simple_hash_combine(HashCode hash_code);
-
-template <typename HashCode, typename T, typename... Ts>
-HashCode simple_hash_combine(
-    HashCode hash_code, const T& value, const Ts&... values);
+// Forward declaration for the mutual recursion below.
+template <typename HashCode, typename... Ts>
+HashCode simple_hash_combine(HashCode hash_code, const Ts&... values);
 
 namespace detail {
 
@@ -337,23 +347,18 @@ HashCode hash_range_or_bytes(HashCode hash_code, InputIterator begin,
 
 }  // namespace detail
 
-// Base case for the simple_hash_combine variadic recursion:
-// simple_hash_combine of no values is a no-op.
-template <typename HashCode>
-HashCode simple_hash_combine(HashCode hash_code) { return hash_code; }
-
-// Recursive variadic case for simple_hash_combine: mix 'value' into the hash
-// state, and then recurse on 'values'.
-template <typename HashCode, typename T, typename... Ts>
-HashCode simple_hash_combine(
-    HashCode hash_code, const T& value, const Ts&... values) {
-  return simple_hash_combine(
-      // Use tag dispatching to select how to mix in 'value': for uniquely-
-      // represented types we can process the bytes directly, and for the
-      // rest we must invoke hash_value().
-      detail::hash_value_or_bytes(std::move(hash_code), value,
-                                  std_::is_uniquely_represented<T>{}),
-      values...);
+// Mixes each of 'values' into the hash state, in order.
+template <typename HashCode, typename... Ts>
+HashCode simple_hash_combine(HashCode hash_code, const Ts&... values) {
+  // Use tag dispatching to select how to mix in each value: for uniquely-
+  // represented types we can process the bytes directly, and for the
+  // rest we must invoke hash_value().
+  (void)detail::expand{
+      0, (hash_code = detail::hash_value_or_bytes(
+              std::move(hash_code), values,
+              std_::is_uniquely_represented<Ts>{}),
+          0)...};
+  return hash_code;
 }
 
 template <typename HashCode, typename InputIterator>
@@ -377,6 +382,57 @@ HashCode simple_hash_combine_range(
 
 template< class... > using void_t = void;
 
+// Compile-time hashed sizes
+// ==========================================================================
+
+// Trait class that gives, as its 'value' member, the number of bytes that
+// hash_combine(code, t) passes to the hash algorithm for every t of type T,
+// if that number is known at compile time. Otherwise it has no 'value'
+// member. Hash algorithms can use this to select a fixed-length code path
+// in place of their streaming logic. Types whose hash_value() feeds only
+// fixed-size values may specialize this; it must be exact.
+template <typename T, typename = void>
+struct fixed_hash_size {};
+
+// Uniquely-represented types are hashed as their bytes.
+template <typename T>
+struct fixed_hash_size<T, enable_if_t<is_uniquely_represented<T>::value>>
+    : public integral_constant<size_t, sizeof(T)> {};
+
+template <>
+struct fixed_hash_size<bool> : public integral_constant<size_t, 1> {};
+
+template <typename Float>
+struct fixed_hash_size<Float, enable_if_t<is_floating_point<Float>::value>>
+    : public integral_constant<size_t, sizeof(Float)> {};
+
+template <typename T, typename U>
+struct fixed_hash_size<
+    pair<T, U>,
+    enable_if_t<!is_uniquely_represented<pair<T, U>>::value,
+                void_t<decltype(fixed_hash_size<T>::value),
+                       decltype(fixed_hash_size<U>::value)>>>
+    : public integral_constant<size_t, fixed_hash_size<T>::value +
+                                           fixed_hash_size<U>::value> {};
+
+template <typename... Ts>
+struct fixed_hash_size<
+    tuple<Ts...>,
+    enable_if_t<!is_uniquely_represented<tuple<Ts...>>::value,
+                void_t<decltype(fixed_hash_size<Ts>::value)...>>>
+    : public integral_constant<
+          size_t,
+          detail::sum<sizeof...(Ts) + 1>({0, fixed_hash_size<Ts>::value...})> {};
+
+// Arrays are hashed as containers, including the size.
+template <typename T, size_t N>
+struct fixed_hash_size<
+    array<T, N>,
+    enable_if_t<!is_uniquely_represented<array<T, N>>::value,
+                void_t<decltype(fixed_hash_size<T>::value)>>>
+    : public integral_constant<size_t, N * fixed_hash_size<T>::value +
+                                           sizeof(size_t)> {};
+
 }  // namespace std_
 
 #endif   // HASHING_DEMO_STD_IMPL_H
@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <string>
+#include <tuple>
+#include <utility>
 
 #include "gtest/gtest.h"
 
@@ -81,6 +85,11 @@ static_assert(is_hashable<Hashable>::value, "");
 static_assert(is_hashable<LegacyHashable>::value, "");
 static_assert(!is_hashable<NotHashable>::value, "");
 
+// Test that std_::hash can be called like std::hash
+static_assert(noexcept(std::declval<const std_::hash<std::string>&>()(
+                  std::declval<const std::string&>())),
+              "");
+
 struct UniquelyRepresented {
   int i = 0;
 
@@ -103,3 +112,175 @@ TEST(StdTest, AppliesUniquelyRepresentedOptimization) {
   EXPECT_EQ(std_::hash<UniquelyRepresented>{}(UniquelyRepresented{42}),
             std_::hash<int>{}(42));
 }
+
+struct CachedInt {
+  int i;
+
+  friend bool operator==(const CachedInt& lhs, const CachedInt& rhs) {
+    return lhs.i == rhs.i;
+  }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const CachedInt& c) {
+    return hash_combine(std::move(h), c.i);
+  }
+};
+
+namespace std_ {
+
+template <>
+struct cache_hash_code<CachedInt> : true_type {};
+
+}  // namespace std_
+
+// A type that is not uniquely represented, but opts out of caching.
+struct UncachedString {
+  std::string s;
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const UncachedString& u) {
+    return hash_combine(std::move(h), u.s);
+  }
+};
+
+namespace std_ {
+
+template <>
+struct cache_hash_code<UncachedString> : false_type {};
+
+}  // namespace std_
+
+static_assert(std_::cache_hash_code<std::string>::value, "");
+static_assert(!std_::cache_hash_code<int>::value, "");
+static_assert(!std_::cache_hash_code<UncachedString>::value, "");
+
+#ifdef __GLIBCXX__
+// libstdc++ decides whether to cache hash codes with std::__cache_default,
+// which consults the reserved std::__is_fast_hash trait that std.h
+// specializes. These check that the specialization still takes effect, in
+// both directions, for the defaults and for types that override them.
+static_assert(std::__cache_default<std::string,
+                                   std_::hash<std::string>>::value, "");
+static_assert(!std::__cache_default<int, std_::hash<int>>::value, "");
+static_assert(std::__cache_default<CachedInt, std_::hash<CachedInt>>::value,
+              "");
+static_assert(!std::__cache_default<UncachedString,
+                                    std_::hash<UncachedString>>::value, "");
+#endif
+
+TEST(StdTest, CachedHashCodes) {
+  std_::unordered_set<CachedInt> set;
+  for (int i = 0; i < 100; ++i) {
+    set.insert(CachedInt{i});
+  }
+  EXPECT_TRUE(set.find(CachedInt{42}) != set.end());
+  EXPECT_TRUE(set.find(CachedInt{100}) == set.end());
+}
+
+// Hashes 'value' with the streaming farmhash implementation, for
+// comparison with std_::hash, which bypasses it for fixed-size types.
+template <typename T>
+size_t StreamingHash(const T& value) {
+  hashing::farmhash::state_type state;
+  return hashing::farmhash::result_type(
+      hash_combine(hashing::farmhash{&state}, value));
+}
+
+struct Point {
+  double x, y;
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const Point& p) {
+    return hash_combine(std::move(h), p.x, p.y);
+  }
+};
+
+namespace std_ {
+
+template <>
+struct fixed_hash_size<Point>
+    : integral_constant<size_t, 2 * fixed_hash_size<double>::value> {};
+
+}  // namespace std_
+
+static_assert(std_::fixed_hash_size<int>::value == sizeof(int), "");
+static_assert(std_::fixed_hash_size<std::pair<bool, double>>::value ==
+                  1 + sizeof(double), "");
+static_assert(std_::fixed_hash_size<std::array<float, 3>>::value ==
+                  3 * sizeof(float) + sizeof(size_t), "");
+static_assert(std_::detail::use_fixed_size_hash<Point>::value, "");
+static_assert(!std_::detail::use_fixed_size_hash<std::string>::value, "");
+static_assert(
+    !std_::detail::use_fixed_size_hash<std::array<uint64_t, 9>>::value, "");
+
+TEST(StdTest, FixedSizeHashMatchesStreamingHash) {
+  EXPECT_EQ(StreamingHash(42), std_::hash<int>{}(42));
+  EXPECT_EQ(StreamingHash(std::tuple<>()),
+            std_::hash<std::tuple<>>{}(std::tuple<>()));
+  const auto triple = std::make_tuple(1, 2, 3);
+  EXPECT_EQ(StreamingHash(triple), std_::hash<decltype(triple)>{}(triple));
+  const auto padded = std::make_pair(uint64_t{1} << 40, uint32_t{7});
+  EXPECT_EQ(StreamingHash(padded), std_::hash<decltype(padded)>{}(padded));
+  const auto flagged = std::make_pair(true, -1.5);
+  EXPECT_EQ(StreamingHash(flagged), std_::hash<decltype(flagged)>{}(flagged));
+  // 17 to 32 bytes.
+  const auto mixed = std::make_tuple(uint64_t{5}, 2.5f, int16_t{-3}, 'c',
+                                     false, uint32_t{9});
+  EXPECT_EQ(StreamingHash(mixed), std_::hash<decltype(mixed)>{}(mixed));
+  // 33 to 64 bytes.
+  const auto wide = std::make_tuple(1.0, 2.0, 3.0, 4.0, 5.0, true);
+  EXPECT_EQ(StreamingHash(wide), std_::hash<decltype(wide)>{}(wide));
+  const std::array<double, 4> doubles = {{0.0, -0.0, 1e300, 3.25}};
+  EXPECT_EQ(StreamingHash(doubles), std_::hash<decltype(doubles)>{}(doubles));
+  EXPECT_EQ(StreamingHash(Point{1.5, -2.0}),
+            std_::hash<Point>{}(Point{1.5, -2.0}));
+  // Too long for the fixed-size path.
+  const std::array<uint64_t, 9> longer = {{1, 2, 3, 4, 5, 6, 7, 8, 9}};
+  EXPECT_EQ(StreamingHash(longer), std_::hash<decltype(longer)>{}(longer));
+}
+
+// Types whose fixed_hash_size specializations are wrong, in each
+// direction. std_::hash must not overrun its buffer for them, and still
+// hashes them as the streaming path does.
+struct Undersized {
+  uint64_t a, b;
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const Undersized& u) {
+    return hash_combine(std::move(h), u.a, u.b);
+  }
+};
+
+struct Oversized {
+  uint64_t a;
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode h, const Oversized& o) {
+    return hash_combine(std::move(h), o.a);
+  }
+};
+
+namespace std_ {
+
+template <>
+struct fixed_hash_size<Undersized> : integral_constant<size_t, 4> {};
+
+template <>
+struct fixed_hash_size<Oversized> : integral_constant<size_t, 16> {};
+
+}  // namespace std_
+
+TEST(StdTest, WrongFixedHashSizeFallsBackToStreaming) {
+  const Undersized undersized{1, 2};
+  EXPECT_EQ(StreamingHash(undersized), std_::hash<Undersized>{}(undersized));
+  const Oversized oversized{3};
+  EXPECT_EQ(StreamingHash(oversized), std_::hash<Oversized>{}(oversized));
+}
+
+TEST(StdTest, ShortStringHashMatchesStreamingHash) {
+  std::string s;
+  for (int size = 0; size <= 80; ++size) {
+    EXPECT_EQ(StreamingHash(s), std_::hash<std::string>{}(s)) << size;
+    s.push_back(static_cast<char>(size * 37));
+  }
+}